@@ -1,53 +1,365 @@
 #include <pebble.h>
 #include "dots.h"
 
-typedef struct DotsLayer {
-	Layer* layer;
-	int8_t num_dots;
-	int8_t active_dot;
-} DotsLayer;
-
-static const int DOT_RAD = 4;
-static const int DOT_INNER_RAD = 2;
+#define DOT_RAD 4
+#define DOT_INNER_RAD 2
 static const int DOT_PITCH = 14; // Center-to-center spacing
+static const int DOT_SLIDE_DURATION = 150;
+// The dots are ORed in white and the indicator's middle is cleared out of them, so they need a black background - incremental redraw paints this.
+static const GColor DOT_BACKGROUND_COLOR = GColorBlack;
+
+// In windowed mode, the dots nearest each edge of the window shrink by a pixel per level when there are more off that side.
+#define DOT_SHRINK_LEVELS 2
+#define DOT_MIN_WINDOW (DOT_SHRINK_LEVELS * 2 + 1) // So the active dot never shrinks.
+
+// Dots are blitted from these rather than rasterized every time.
+#define DOT_SIZE (DOT_RAD * 2 + 1)
+#define DOT_SPRITE_ROW_SIZE (((DOT_SIZE + 31) / 32) * 4)
+static uint8_t s_dot_pixels[DOT_SHRINK_LEVELS + 1][DOT_SIZE * DOT_SPRITE_ROW_SIZE];
+static uint8_t s_inner_dot_pixels[DOT_SIZE * DOT_SPRITE_ROW_SIZE];
+static GBitmap s_dot_sprites[DOT_SHRINK_LEVELS + 1];
+static GBitmap s_inner_dot_sprite;
+static bool s_sprites_ready = false;
+
+static void dots_rasterize_dot(uint8_t* pixels, int radius) {
+	memset(pixels, 0, DOT_SIZE * DOT_SPRITE_ROW_SIZE);
+	for (int y = 0; y < DOT_SIZE; ++y) {
+		for (int x = 0; x < DOT_SIZE; ++x) {
+			int dx = x - DOT_RAD;
+			int dy = y - DOT_RAD;
+			if (dx * dx + dy * dy <= radius * radius + radius) {
+				pixels[y * DOT_SPRITE_ROW_SIZE + x / 8] |= 1 << (x % 8);
+			}
+		}
+	}
+}
+
+static void dots_init_sprite(GBitmap* sprite, uint8_t* pixels, GContext* ctx) {
+	// The sprites only ever get ORed (or cleared) onto the framebuffer, so they take its format - just the pixels and size are their own.
+	memcpy(sprite, ctx, sizeof(GBitmap));
+	sprite->addr = pixels;
+	sprite->row_size_bytes = DOT_SPRITE_ROW_SIZE;
+	sprite->bounds = GRect(0, 0, DOT_SIZE, DOT_SIZE);
+	sprite->is_heap_allocated = false;
+}
+
+static void dots_init_sprites(GContext* ctx) {
+	if (s_sprites_ready) return;
+	for (int level = 0; level <= DOT_SHRINK_LEVELS; ++level) {
+		dots_rasterize_dot(s_dot_pixels[level], DOT_RAD - level);
+		dots_init_sprite(&s_dot_sprites[level], s_dot_pixels[level], ctx);
+	}
+	dots_rasterize_dot(s_inner_dot_pixels, DOT_INNER_RAD);
+	dots_init_sprite(&s_inner_dot_sprite, s_inner_dot_pixels, ctx);
+	s_sprites_ready = true;
+}
+
+#ifdef DOTS_PROFILE
+static uint32_t dots_now_ms(void) {
+	time_t s;
+	uint16_t ms;
+	time_ms(&s, &ms);
+	return (uint32_t)s * 1000 + ms;
+}
+#endif
+
+static int32_t dots_layer_visible_count(DotsLayer* dl) {
+	if (dl->max_visible == 0 || dl->num_dots <= dl->max_visible) return dl->num_dots;
+	return dl->max_visible;
+}
+
+// Keeps the active dot in the middle of the window, until it runs into either end.
+static int32_t dots_layer_window_start(DotsLayer* dl, int32_t count) {
+	int32_t first = dl->active_dot - count / 2;
+	if (first > dl->num_dots - count) first = dl->num_dots - count;
+	if (first < 0) first = 0;
+	return first;
+}
+
+static int dots_layer_dot_level(DotsLayer* dl, int32_t first, int32_t count, int32_t j) {
+	int level = 0;
+	if (first > 0 && j < DOT_SHRINK_LEVELS) {
+		level = DOT_SHRINK_LEVELS - j;
+	}
+	int32_t from_end = count - 1 - j;
+	if (first + count < dl->num_dots && from_end < DOT_SHRINK_LEVELS && DOT_SHRINK_LEVELS - from_end > level) {
+		level = DOT_SHRINK_LEVELS - from_end;
+	}
+	return level;
+}
+
+// Where the middle gets punched out: over the active dot, or part way there while sliding.
+static int dots_layer_indicator_x(DotsLayer* dl, int dots_left, int32_t first, int32_t count) {
+	int to_x = dots_left + (dl->active_dot - first) * DOT_PITCH;
+	if (!dl->sliding) return to_x;
+	// A dot that's scrolled out of the window slides in from the nearest end.
+	int32_t from = dl->slide_from - first;
+	if (from < 0) from = 0;
+	if (from > count - 1) from = count - 1;
+	int from_x = dots_left + from * DOT_PITCH;
+	return from_x + (to_x - from_x) * (int32_t)dl->slide_progress / (int32_t)ANIMATION_NORMALIZED_MAX;
+}
+
+static void dots_draw_sprite(DotsLayer* dl, GContext* ctx, GBitmap* sprite, GPoint center) {
+#ifdef DOTS_PROFILE
+	dl->profile.draw_calls++;
+	dl->profile.pixels_filled += DOT_SIZE * DOT_SIZE;
+#endif
+	graphics_draw_bitmap_in_rect(ctx, sprite, GRect(center.x - DOT_RAD, center.y - DOT_RAD, DOT_SIZE, DOT_SIZE));
+}
+
+// Repaints the dots that overlap columns x0 to x1 (covering up the middle, if it used to be punched out of them).
+static void dots_draw_span(DotsLayer* dl, GContext* ctx, int dots_left, int32_t first, int32_t count, int x0, int x1) {
+	int32_t j0 = (x0 - DOT_RAD - dots_left) / DOT_PITCH;
+	int32_t j1 = (x1 + DOT_RAD - dots_left) / DOT_PITCH;
+	if (j0 < 0) j0 = 0;
+	if (j1 > count - 1) j1 = count - 1;
+	graphics_context_set_compositing_mode(ctx, GCompOpOr);
+	for (int32_t j = j0; j <= j1; ++j) {
+		int level = dots_layer_dot_level(dl, first, count, j);
+		dots_draw_sprite(dl, ctx, &s_dot_sprites[level], GPoint(dots_left + j * DOT_PITCH, DOT_RAD));
+	}
+}
+
+// Paints the background over the layer's bounds, and columns x0 to x1 (where the dots were last drawn, which may be outside them), over the full height of a dot.
+static void dots_clear(DotsLayer* dl, GContext* ctx, GRect bounds, int x0, int x1) {
+	if (bounds.origin.x < x0) x0 = bounds.origin.x;
+	if (bounds.origin.x + bounds.size.w > x1) x1 = bounds.origin.x + bounds.size.w;
+	int h = bounds.size.h > DOT_SIZE ? bounds.size.h : DOT_SIZE;
+#ifdef DOTS_PROFILE
+	dl->profile.draw_calls++;
+	dl->profile.pixels_filled += (x1 - x0) * h;
+#endif
+	graphics_context_set_fill_color(ctx, DOT_BACKGROUND_COLOR);
+	graphics_fill_rect(ctx, GRect(x0, 0, x1 - x0, h), 0, GCornerNone);
+}
 
 static void dots_layer_update_proc(Layer *layer, GContext* ctx) {
 	GRect bounds = layer_get_bounds(layer);
 	DotsLayer* dl = *(DotsLayer**)layer_get_data(layer);
-	int dots_left = bounds.size.w / 2 - ((dl->num_dots - 1) * DOT_PITCH) / 2;
-	for (int i = 0; i < dl->num_dots; ++i) {
-		graphics_context_set_fill_color(ctx, GColorWhite);
-		graphics_fill_circle(ctx, GPoint(dots_left + i * DOT_PITCH, DOT_RAD), DOT_RAD);
-		if (i == dl->active_dot) {
-			graphics_context_set_fill_color(ctx, GColorBlack);
-			graphics_fill_circle(ctx, GPoint(dots_left + i * DOT_PITCH, DOT_RAD), DOT_INNER_RAD);
+#ifdef DOTS_PROFILE
+	uint32_t start_ms = dots_now_ms();
+	dl->profile.frame++;
+	dl->profile.draw_calls = 0;
+	dl->profile.pixels_filled = 0;
+#endif
+	dots_init_sprites(ctx);
+	int32_t count = dots_layer_visible_count(dl);
+	int32_t first = dots_layer_window_start(dl, count);
+	int dots_left = bounds.size.w / 2 - ((count - 1) * DOT_PITCH) / 2;
+	int indicator_x = dots_layer_indicator_x(dl, dots_left, first, count);
+	if (dl->incremental_redraw && !dl->needs_full_redraw && bounds.size.w == dl->drawn_width && first == dl->drawn_first) {
+		// Everything else is still in the framebuffer from last time.
+		int last_x = dl->drawn_indicator_x;
+		if (abs(indicator_x - last_x) <= DOT_PITCH) {
+			// Sliding - just the dots we've passed over.
+			dots_draw_span(dl, ctx, dots_left, first, count, (indicator_x < last_x ? indicator_x : last_x) - DOT_INNER_RAD, (indicator_x > last_x ? indicator_x : last_x) + DOT_INNER_RAD);
+		} else {
+			dots_draw_span(dl, ctx, dots_left, first, count, last_x - DOT_INNER_RAD, last_x + DOT_INNER_RAD);
+			dots_draw_span(dl, ctx, dots_left, first, count, indicator_x - DOT_INNER_RAD, indicator_x + DOT_INNER_RAD);
 		}
+	} else {
+		if (dl->incremental_redraw) {
+			// The dots are ORed in, so whatever was there last time (the dots may have moved, shrunk or gone) has to go first.
+			dots_clear(dl, ctx, bounds, dl->drawn_left, dl->drawn_right);
+		}
+		dots_draw_span(dl, ctx, dots_left, first, count, dots_left, dots_left + (count - 1) * DOT_PITCH);
+	}
+	if (dl->active_dot >= 0 && dl->active_dot < dl->num_dots) {
+		// Clearing punches the black middle back out.
+		graphics_context_set_compositing_mode(ctx, GCompOpClear);
+		dots_draw_sprite(dl, ctx, &s_inner_dot_sprite, GPoint(indicator_x, DOT_RAD));
 	}
+	dl->needs_full_redraw = false;
+	dl->drawn_width = bounds.size.w;
+	dl->drawn_first = first;
+	dl->drawn_indicator_x = indicator_x;
+	dl->drawn_left = count ? dots_left - DOT_RAD : 0;
+	dl->drawn_right = count ? dots_left + (count - 1) * DOT_PITCH + DOT_RAD + 1 : 0;
+#ifdef DOTS_PROFILE
+	dl->profile.wall_time_ms = dots_now_ms() - start_ms;
+	if (dl->profile_handler) {
+		dl->profile_handler(dl, &dl->profile, dl->profile_context);
+	}
+#endif
 }
 
-DotsLayer* dots_layer_create(GRect frame) {
-	DotsLayer* dl = malloc(sizeof(DotsLayer));
+static void dots_animation_update(Animation* animation, const uint32_t time_normal) {
+	DotsLayer* dl = (DotsLayer*)animation_get_context(animation);
+	dl->slide_progress = time_normal;
+	layer_mark_dirty(dl->layer);
+}
+
+static void dots_animation_stopped(Animation* animation, bool finished, void* context) {
+	DotsLayer* dl = (DotsLayer*)context;
+	dl->sliding = false;
+	layer_mark_dirty(dl->layer);
+}
+
+static const AnimationImplementation dots_animation_implementation = {
+	.setup = NULL,
+	.update = dots_animation_update,
+	.teardown = NULL
+};
+
+static void dots_layer_stop_slide(DotsLayer* dl) {
+	if (dl->anim && animation_is_scheduled(dl->anim)) {
+		animation_unschedule(dl->anim);
+	}
+	dl->sliding = false;
+}
+
+// Everything the layer needs from the firmware is got here, so updating and sliding never allocate.
+static DotsLayer* dots_layer_init_internal(DotsLayerStorage* storage, GRect frame, bool own_animation) {
+	DotsLayer* dl = (DotsLayer*)storage;
 	dl->layer = layer_create_with_data(frame, sizeof(DotsLayer*));
+	dl->anim = own_animation ? animation_create() : NULL;
+	if (!dl->layer || (own_animation && !dl->anim)) {
+		if (dl->layer) layer_destroy(dl->layer);
+		if (dl->anim) animation_destroy(dl->anim);
+		return NULL;
+	}
 	*(DotsLayer**)layer_get_data(dl->layer) = dl;
 	layer_set_clips(dl->layer, false);
 	dl->num_dots = 0;
 	dl->active_dot = 0;
+	dl->max_visible = 0;
+	dl->animated = false;
+	dl->sliding = false;
+	dl->slide_from = 0;
+	dl->slide_progress = 0;
+	dl->incremental_redraw = false;
+	dl->needs_full_redraw = true;
+	dl->drawn_width = 0;
+	dl->drawn_first = 0;
+	dl->drawn_indicator_x = 0;
+	dl->drawn_left = 0;
+	dl->drawn_right = 0;
+#ifdef DOTS_PROFILE
+	memset(&dl->profile, 0, sizeof(DotsLayerProfile));
+	dl->profile_handler = NULL;
+#endif
 
 	layer_set_update_proc(dl->layer, dots_layer_update_proc);
+	if (dl->anim) {
+		AnimationHandlers callbacks = {
+			.started = NULL,
+			.stopped = dots_animation_stopped
+		};
+		animation_set_handlers(dl->anim, callbacks, dl);
+		animation_set_implementation(dl->anim, &dots_animation_implementation);
+	}
+	return dl;
+}
+
+static DotsLayer* dots_layer_create_internal(GRect frame, bool own_animation) {
+	DotsLayerStorage* storage = malloc(sizeof(DotsLayer));
+	if (!storage) return NULL;
+	DotsLayer* dl = dots_layer_init_internal(storage, frame, own_animation);
+	if (!dl) {
+		free(storage);
+	}
 	return dl;
 }
 
+DotsLayer* dots_layer_init(DotsLayerStorage* storage, GRect frame) {
+	return dots_layer_init_internal(storage, frame, true);
+}
+
+DotsLayer* dots_layer_init_driven(DotsLayerStorage* storage, GRect frame) {
+	return dots_layer_init_internal(storage, frame, false);
+}
+
+DotsLayer* dots_layer_create(GRect frame) {
+	return dots_layer_create_internal(frame, true);
+}
+
+DotsLayer* dots_layer_create_driven(GRect frame) {
+	return dots_layer_create_internal(frame, false);
+}
+
 Layer* dots_layer_get_layer(DotsLayer* dots_layer) {
 	return dots_layer->layer;
 }
 
-void dots_layer_update(DotsLayer* dots_layer, int8_t num_dots, int8_t active_dot) {
+void dots_layer_update(DotsLayer* dots_layer, int32_t num_dots, int32_t active_dot) {
+	if (num_dots == dots_layer->num_dots && active_dot == dots_layer->active_dot) return;
+	if (num_dots != dots_layer->num_dots) {
+		// Everything moves.
+		dots_layer_stop_slide(dots_layer);
+		dots_layer->needs_full_redraw = true;
+	} else if (dots_layer->animated && dots_layer_begin_slide(dots_layer, active_dot)) {
+		if (dots_layer->anim) {
+			animation_set_duration(dots_layer->anim, DOT_SLIDE_DURATION);
+			animation_schedule(dots_layer->anim);
+		} else {
+			// Made to be slid from outside, so there's no animation of our own - jump straight there.
+			dots_layer->sliding = false;
+		}
+	}
 	dots_layer->num_dots = num_dots;
 	dots_layer->active_dot = active_dot;
 	layer_mark_dirty(dots_layer->layer);
 }
 
-void dots_layer_destroy(DotsLayer* dots_layer) {
+bool dots_layer_begin_slide(DotsLayer* dots_layer, int32_t active_dot) {
+	// Whatever was going on before gets cut short (unscheduling runs the stopped handler, so do it before setting up the new slide).
+	dots_layer_stop_slide(dots_layer);
+	if (active_dot == dots_layer->active_dot) return false;
+	dots_layer->sliding = true;
+	dots_layer->slide_from = dots_layer->active_dot;
+	dots_layer->slide_progress = 0;
+	dots_layer->active_dot = active_dot;
+	return true;
+}
+
+void dots_layer_set_slide_progress(DotsLayer* dots_layer, uint32_t time_normal) {
+	dots_layer->slide_progress = time_normal;
+}
+
+void dots_layer_end_slide(DotsLayer* dots_layer) {
+	dots_layer->sliding = false;
+}
+
+void dots_layer_set_max_visible(DotsLayer* dots_layer, uint8_t max_visible) {
+	if (max_visible != 0 && max_visible < DOT_MIN_WINDOW) {
+		max_visible = DOT_MIN_WINDOW;
+	}
+	dots_layer->max_visible = max_visible;
+	dots_layer->needs_full_redraw = true;
+	layer_mark_dirty(dots_layer->layer);
+}
+
+void dots_layer_set_animated(DotsLayer* dots_layer, bool animated) {
+	dots_layer->animated = animated;
+	if (!animated && dots_layer->sliding) {
+		dots_layer_stop_slide(dots_layer);
+		layer_mark_dirty(dots_layer->layer);
+	}
+}
+
+void dots_layer_set_incremental_redraw(DotsLayer* dots_layer, bool enabled) {
+	dots_layer->incremental_redraw = enabled;
+	dots_layer->needs_full_redraw = true;
+	layer_mark_dirty(dots_layer->layer);
+}
+
+#ifdef DOTS_PROFILE
+void dots_layer_set_profile_handler(DotsLayer* dots_layer, DotsLayerProfileHandler handler, void* context) {
+	dots_layer->profile_handler = handler;
+	dots_layer->profile_context = context;
+}
+#endif
+
+void dots_layer_deinit(DotsLayer* dots_layer) {
+	dots_layer_stop_slide(dots_layer);
+	if (dots_layer->anim) {
+		animation_destroy(dots_layer->anim);
+	}
 	layer_destroy(dots_layer->layer);
+}
+
+void dots_layer_destroy(DotsLayer* dots_layer) {
+	dots_layer_deinit(dots_layer);
 	free(dots_layer);
 }
@@ -1,8 +1,56 @@
+#pragma once
 #include <pebble.h>
 struct DotsLayer;
 typedef struct DotsLayer DotsLayer;
 
+#ifdef DOTS_PROFILE
+// What it cost to draw one frame of the dots.
+typedef struct DotsLayerProfile {
+	uint32_t frame;
+	uint16_t draw_calls;
+	uint32_t pixels_filled;
+	uint16_t wall_time_ms;
+} DotsLayerProfile;
+
+typedef void (*DotsLayerProfileHandler)(DotsLayer* dots_layer, const DotsLayerProfile* profile, void* context);
+#endif
+
+#include "dots_private.h"
+
+// Enough room for a DotsLayer, for dots_layer_init - its actual size, on whatever you're building for.
+#define DOTS_LAYER_STORAGE_SIZE sizeof(struct DotsLayer)
+
+typedef union DotsLayerStorage {
+	uint8_t bytes[DOTS_LAYER_STORAGE_SIZE];
+	struct DotsLayer align;
+} DotsLayerStorage;
+
+// NULL if there isn't the memory.
 DotsLayer* dots_layer_create(GRect frame);
+// Same, but in the DotsLayerStorage given. Pair with dots_layer_deinit.
+DotsLayer* dots_layer_init(DotsLayerStorage* storage, GRect frame);
+// For a layer whose indicator only ever slides from outside (a Transition, or dots_layer_begin_slide and friends): no Animation of its own,
+// so dots_layer_update just moves the indicator, even with animation on.
+DotsLayer* dots_layer_create_driven(GRect frame);
+DotsLayer* dots_layer_init_driven(DotsLayerStorage* storage, GRect frame);
 Layer* dots_layer_get_layer(DotsLayer* dots_layer);
-void dots_layer_update(DotsLayer* dots_layer, int8_t num_dots, int8_t active_dot);
+void dots_layer_update(DotsLayer* dots_layer, int32_t num_dots, int32_t active_dot);
+// Only show this many dots at once, shrinking the ones at the edges when there are more beyond (0 shows them all).
+void dots_layer_set_max_visible(DotsLayer* dots_layer, uint8_t max_visible);
+// Slide the active indicator over to the new dot, rather than jumping.
+void dots_layer_set_animated(DotsLayer* dots_layer, bool animated);
+// For sliding the indicator from your own Animation: begin a slide to active_dot (false if it's already there),
+// feed it the animation's time_normal, and end it. None of these mark the layer dirty - that's up to you, once per frame.
+bool dots_layer_begin_slide(DotsLayer* dots_layer, int32_t active_dot);
+void dots_layer_set_slide_progress(DotsLayer* dots_layer, uint32_t time_normal);
+void dots_layer_end_slide(DotsLayer* dots_layer);
+// Only repaint the dots whose look changed (the old and new active dots, or the ones the indicator slid over). The rest of the
+// dot strip is whatever the last frame left there, so the window mustn't paint over it first - give it a GColorClear background.
+// When the dots all need repainting (the count changed, or the window scrolled), the layer's bounds and wherever the dots were last
+// drawn are filled with GColorBlack first, so whatever's behind the layer has to be black there (as it does for the dots to show anyway).
+void dots_layer_set_incremental_redraw(DotsLayer* dots_layer, bool enabled);
+#ifdef DOTS_PROFILE
+void dots_layer_set_profile_handler(DotsLayer* dots_layer, DotsLayerProfileHandler handler, void* context);
+#endif
 void dots_layer_destroy(DotsLayer* dots_layer);
+void dots_layer_deinit(DotsLayer* dots_layer);
@@ -0,0 +1,31 @@
+#pragma once
+// What a DotsLayer is made of. dots.h includes this so that DOTS_LAYER_STORAGE_SIZE can be the real size on every target,
+// padding and all - none of it is for using directly, and it changes whenever the control does.
+
+struct DotsLayer {
+	Layer* layer;
+	int32_t num_dots;
+	int32_t active_dot;
+	uint8_t max_visible; // 0 shows every dot.
+
+	// Sliding the active indicator
+	bool animated;
+	Animation* anim;
+	bool sliding;
+	int32_t slide_from; // The dot the indicator is leaving.
+	uint32_t slide_progress;
+
+	// Incremental redraw
+	bool incremental_redraw;
+	bool needs_full_redraw;
+	int16_t drawn_width; // The width we last drew at.
+	int32_t drawn_first; // The first visible dot last time.
+	int16_t drawn_indicator_x; // Where the middle was punched out last time.
+	int16_t drawn_left; // The columns the dots covered last time.
+	int16_t drawn_right;
+#ifdef DOTS_PROFILE
+	DotsLayerProfile profile;
+	DotsLayerProfileHandler profile_handler;
+	void* profile_context;
+#endif
+};
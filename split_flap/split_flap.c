@@ -1,37 +1,132 @@
 #include <pebble.h>
 #include "split_flap.h"
 
-static const int FLAP_INSET = 4; // The padding around the flap area itself
-static const int FLAP_SPLIT_HEIGHT = 4; // The height of the middle divider
+// The inset, divider, colours, corner radius and geometry steps are in split_flap_private.h, since SplitFlapBank draws its cells with them too.
 static const int FLAP_ANIMATION_DURATION = 200; // msec
-static const GColor FLAP_BACKGROUND_COLOR = GColorWhite; // Colour of the flap background
-static const GColor FLAP_FOREGROUND_COLOR = GColorBlack; // Colour of the frame, divider, flap border.
+static const int FLAP_MIN_ANIMATION_DURATION = 80; // msec, for queued flips
+static const int FLAP_QUEUE_MAX_FLIPS = 3; // Any more queued than this and we start skipping pages
+#ifdef SPLIT_FLAP_STATS
+static const int FLAP_STATS_FRAME_MS = 33; // How often the firmware should be ticking animations
+#endif
+#define SPLIT_FLAP_PAGE_UNBOUND UINT32_MAX
+// The governor draws every 1, 2, 4 or 8 geometry steps.
+#define FLAP_GOVERNOR_MAX_STRIDE 8
+#define FLAP_GOVERNOR_LOW_BATTERY_STRIDE 4
 
-typedef struct SplitFlapLayer {
-  // Internal layers
-  Layer* layer;
-  Layer* mask_layer;
-  GBitmap* mask_bmp;
+// Everything that needs the time gets it from here - define SPLIT_FLAP_CLOCK_MS() yourself to run on a fake clock.
+#ifndef SPLIT_FLAP_CLOCK_MS
+static uint32_t split_flap_now_ms(void) {
+  time_t s;
+  uint16_t ms;
+  time_ms(&s, &ms);
+  return (uint32_t)s * 1000 + ms;
+}
+#define SPLIT_FLAP_CLOCK_MS() split_flap_now_ms()
+#endif
 
-  // Pages
-  SplitFlapLayerPage* pages;
-  uint32_t num_pages;
-  uint32_t current_page;
-
-  SplitFlapLayerCallbacks callbacks;
-
-  // Animation state
-  Animation* anim;
-  AnimationImplementation* anim_implementation;
-  bool anim_forward;
-  uint32_t anim_progress;
-  uint32_t anim_appearing_page;
-  uint32_t anim_disappearing_page;
-} SplitFlapLayer;
-
-// Shamelessly copy-pasted from the firmware.
-static int32_t animation_timing_function_ease_in_out(uint32_t time_normalized) {
-  static const uint16_t ease_in_out_table[32] = {
+#ifdef SPLIT_FLAP_PROFILE
+static void split_flap_profile_cover(SplitFlapLayer* split_layer, GRect rect) {
+  if (rect.size.w <= 0 || rect.size.h <= 0 || split_layer->profile_num_rects == SPLIT_FLAP_PROFILE_MAX_RECTS) return;
+  split_layer->profile_rects[split_layer->profile_num_rects++] = rect;
+}
+
+// How much of the frame got covered more than once: each row's total coverage, less its union.
+static uint32_t split_flap_profile_overdraw(SplitFlapLayer* split_layer, GRect bounds) {
+  uint32_t overdraw = 0;
+  int16_t starts[SPLIT_FLAP_PROFILE_MAX_RECTS];
+  int16_t ends[SPLIT_FLAP_PROFILE_MAX_RECTS];
+  for (int y = bounds.origin.y; y < bounds.origin.y + bounds.size.h; ++y) {
+    int n = 0;
+    for (int i = 0; i < split_layer->profile_num_rects; ++i) {
+      GRect* r = &split_layer->profile_rects[i];
+      if (y < r->origin.y || y >= r->origin.y + r->size.h) continue;
+      // Insertion sort by start.
+      int j = n++;
+      for (; j > 0 && starts[j - 1] > r->origin.x; --j) {
+        starts[j] = starts[j - 1];
+        ends[j] = ends[j - 1];
+      }
+      starts[j] = r->origin.x;
+      ends[j] = r->origin.x + r->size.w;
+    }
+    int covered_to = INT16_MIN;
+    for (int i = 0; i < n; ++i) {
+      int overlap = (ends[i] < covered_to ? ends[i] : covered_to) - starts[i];
+      if (overlap > 0) overdraw += overlap;
+      if (ends[i] > covered_to) covered_to = ends[i];
+    }
+  }
+  return overdraw;
+}
+
+static void split_flap_profile_count_empty_layers(SplitFlapLayer* split_layer, SplitFlapLayerPage* page) {
+  Layer* halves[2] = {page->upperLayer, page->lowerLayer};
+  for (int i = 0; i < 2; ++i) {
+    if (layer_get_hidden(halves[i])) continue;
+    GRect frame = layer_get_frame(halves[i]);
+    if (frame.size.w <= 0 || frame.size.h <= 0) {
+      split_layer->profile.empty_layer_draws++;
+    }
+  }
+}
+
+// A hash of the control's pixels, as they are on screen.
+static uint32_t split_flap_profile_checksum(GBitmap* framebuffer, GRect rect) {
+  uint32_t hash = 2166136261u; // FNV-1a
+  int x0 = rect.origin.x > framebuffer->bounds.origin.x ? rect.origin.x : framebuffer->bounds.origin.x;
+  int y0 = rect.origin.y > framebuffer->bounds.origin.y ? rect.origin.y : framebuffer->bounds.origin.y;
+  int x1 = rect.origin.x + rect.size.w;
+  int y1 = rect.origin.y + rect.size.h;
+  int fb_x1 = framebuffer->bounds.origin.x + framebuffer->bounds.size.w;
+  int fb_y1 = framebuffer->bounds.origin.y + framebuffer->bounds.size.h;
+  x1 = x1 < fb_x1 ? x1 : fb_x1;
+  y1 = y1 < fb_y1 ? y1 : fb_y1;
+  for (int y = y0; y < y1; ++y) {
+    const uint8_t* row = (const uint8_t*)framebuffer->addr + y * framebuffer->row_size_bytes;
+    for (int x = x0; x < x1; ++x) {
+      hash = (hash ^ ((row[x / 8] >> (x % 8)) & 1)) * 16777619u;
+    }
+  }
+  return hash;
+}
+#endif
+
+// All drawing and page layer juggling goes through these, so the profiler sees it.
+static void split_flap_fill_rect(SplitFlapLayer* split_layer, GContext* ctx, GRect rect, uint16_t corner_radius, GCornerMask corner_mask) {
+#ifdef SPLIT_FLAP_PROFILE
+  split_layer->profile.draw_calls++;
+  split_layer->profile.pixels_filled += rect.size.w * rect.size.h;
+  split_flap_profile_cover(split_layer, rect);
+#endif
+  graphics_fill_rect(ctx, rect, corner_radius, corner_mask);
+}
+
+static void split_flap_draw_bitmap(SplitFlapLayer* split_layer, GContext* ctx, const GBitmap* bitmap, GRect rect) {
+#ifdef SPLIT_FLAP_PROFILE
+  split_layer->profile.draw_calls++;
+  split_layer->profile.pixels_filled += rect.size.w * rect.size.h;
+  split_flap_profile_cover(split_layer, rect);
+#endif
+  graphics_draw_bitmap_in_rect(ctx, bitmap, rect);
+}
+
+static void split_flap_set_page_frame(SplitFlapLayer* split_layer, Layer* layer, GRect frame) {
+#ifdef SPLIT_FLAP_PROFILE
+  split_layer->profile.frame_sets++;
+#endif
+  layer_set_frame(layer, frame);
+}
+
+static void split_flap_set_page_bounds(SplitFlapLayer* split_layer, Layer* layer, GRect bounds) {
+#ifdef SPLIT_FLAP_PROFILE
+  split_layer->profile.bounds_sets++;
+#endif
+  layer_set_bounds(layer, bounds);
+}
+
+// Easing curves, one entry per 2048 of time_normalized (the last one being ANIMATION_NORMALIZED_MAX) and interpolated in between.
+// This is the firmware's ease-in-out curve, as the control has always used it (entry by entry), plus an end point to interpolate towards.
+static const uint16_t ease_in_out_table[33] = {
   0,      136,    545,    1227,
   2182,   3409,   4909,   6682,
   8728,   11047,  13638,  16502,
@@ -39,35 +134,209 @@ static int32_t animation_timing_function_ease_in_out(uint32_t time_normalized) {
   34847,  38803,  42485,  45895,
   49032,  51896,  54488,  56806,
   58852,  60625,  62126,  63353,
-  64308,  64990,  65399,  65535
-  };
-  const uint8_t index = time_normalized / 2048;
-  return ease_in_out_table[index];
+  64308,  64990,  65399,  65535,
+  65535
+};
+
+// Falls faster and faster until it hits the bottom at 3/4 of the way through, then bounces a little.
+static const uint16_t gravity_table[33] = {
+  0,      114,    455,    1024,
+  1820,   2844,   4096,   5575,
+  7282,   9216,   11378,  13767,
+  16384,  19228,  22300,  25600,
+  29127,  32881,  36863,  41073,
+  45510,  50175,  55068,  60188,
+  65535,  64030,  62755,  61902,
+  61603,  61902,  62755,  64030,
+  65535
+};
+
+uint32_t split_flap_ease(SplitFlapEasing easing, uint32_t time_normalized) {
+  const uint16_t* table;
+  switch (easing) {
+    case SplitFlapEasingLinear: return time_normalized;
+    case SplitFlapEasingGravity: table = gravity_table; break;
+    default: table = ease_in_out_table; break;
+  }
+  const uint32_t index = time_normalized / 2048;
+  const int32_t frac = time_normalized % 2048;
+  return table[index] + ((table[index + 1] - table[index]) * frac) / 2048;
 }
 
 void split_flap_layer_set_current_page(SplitFlapLayer* split_layer, uint32_t page, bool animated);
+static SplitFlapLayerPage* split_flap_layer_get_page(SplitFlapLayer* split_layer, uint32_t page_idx);
 
 static void split_flap_page_layer_setup(SplitFlapLayer* split_layer, SplitFlapLayerPage* page) {
   GRect flapBounds = grect_crop(layer_get_bounds(split_layer->layer), FLAP_INSET);
   int split_y = flapBounds.origin.y + flapBounds.size.h / 2;
-  layer_set_frame(page->upperLayer, GRect(flapBounds.origin.x, flapBounds.origin.y, flapBounds.size.w, flapBounds.size.h / 2));
-  layer_set_bounds(page->upperLayer, GRect(0, 0, flapBounds.size.w, flapBounds.size.h / 2));
-  layer_set_frame(page->lowerLayer, GRect(flapBounds.origin.x, split_y, flapBounds.size.w, flapBounds.size.h / 2));
-  layer_set_bounds(page->lowerLayer, GRect(0, 0, flapBounds.size.w, flapBounds.size.h / 2));
+  split_flap_set_page_frame(split_layer, page->upperLayer, GRect(flapBounds.origin.x, flapBounds.origin.y, flapBounds.size.w, flapBounds.size.h / 2));
+  split_flap_set_page_bounds(split_layer, page->upperLayer, GRect(0, 0, flapBounds.size.w, flapBounds.size.h / 2));
+  split_flap_set_page_frame(split_layer, page->lowerLayer, GRect(flapBounds.origin.x, split_y, flapBounds.size.w, flapBounds.size.h / 2));
+  split_flap_set_page_bounds(split_layer, page->lowerLayer, GRect(0, 0, flapBounds.size.w, flapBounds.size.h / 2));
+}
+
+static uint32_t split_flap_layer_wrap_page(SplitFlapLayer* split_layer, uint32_t page_idx, int32_t delta) {
+  int32_t num_pages = split_layer->num_pages;
+  return (((int32_t)page_idx + delta) % num_pages + num_pages) % num_pages;
+}
+
+static void split_flap_layer_notify_page_changed(SplitFlapLayer* split_layer, uint32_t old_page_idx, uint32_t new_page_idx) {
+  if (old_page_idx != new_page_idx && split_layer->callbacks.page_changed) {
+    split_layer->callbacks.page_changed(split_layer, old_page_idx, new_page_idx);
+  }
+}
+
+// Swap the visible page, no questions asked.
+static void split_flap_layer_show_page(SplitFlapLayer* split_layer, uint32_t page_idx) {
+  SplitFlapLayerPage* oldPage = split_flap_layer_get_page(split_layer, split_layer->current_page);
+  SplitFlapLayerPage* newPage = split_flap_layer_get_page(split_layer, page_idx);
+  layer_set_hidden(oldPage->upperLayer, true);
+  layer_set_hidden(oldPage->lowerLayer, true);
+
+  layer_set_hidden(newPage->upperLayer, false);
+  layer_set_hidden(newPage->lowerLayer, false);
+  split_layer->current_page = page_idx;
+}
+
+static void split_flap_layer_flip_next_queued(SplitFlapLayer* split_layer);
+
+static void split_flap_layer_set_progress(SplitFlapLayer* split_layer, uint32_t time_normal) {
+  // Make the animation look cool.
+  split_layer->anim_progress = split_flap_ease(split_layer->easing, time_normal);
+  split_layer->anim_step = (split_layer->anim_progress + FLAP_GEOMETRY_STEP_SIZE / 2) / FLAP_GEOMETRY_STEP_SIZE;
+  if (split_layer->governor_enabled) {
+    uint32_t stride = split_layer->governor_stride;
+    split_layer->anim_step = ((split_layer->anim_step + stride / 2) / stride) * stride;
+  }
+}
+
+// Called with what each frame of a flip cost, to decide how many steps the next ones get.
+static void split_flap_layer_govern(SplitFlapLayer* split_layer, uint32_t frame_ms) {
+  split_layer->governor_frame_ms = (split_layer->governor_frame_ms * 3 + frame_ms) / 4;
+  uint16_t budget = split_layer->governor.frame_budget_ms;
+  if (budget && split_layer->governor_frame_ms > budget) {
+    if (split_layer->governor_stride < FLAP_GOVERNOR_MAX_STRIDE) {
+      split_layer->governor_stride *= 2;
+    }
+  } else if (!budget || split_layer->governor_frame_ms < budget / 2) {
+    if (split_layer->governor_stride > split_layer->governor_min_stride) {
+      split_layer->governor_stride /= 2;
+    }
+  }
+}
+
+static void split_flap_layer_check_battery(SplitFlapLayer* split_layer) {
+  split_layer->governor_min_stride = 1;
+  if (split_layer->governor.low_battery_percent) {
+    BatteryChargeState battery = battery_state_service_peek();
+    if (!battery.is_charging && battery.charge_percent <= split_layer->governor.low_battery_percent) {
+      split_layer->governor_min_stride = FLAP_GOVERNOR_LOW_BATTERY_STRIDE;
+    }
+  }
+  if (split_layer->governor_stride < split_layer->governor_min_stride) {
+    split_layer->governor_stride = split_layer->governor_min_stride;
+  }
+}
+
+// Work out the flap height and corner radius for every step of a flip, so drawing a frame is just a lookup.
+void split_flap_build_geometry(SplitFlapGeometryStep* steps, GRect flapBounds) {
+  // A flap a pixel or two tall has no room for rounded corners (and nothing to divide them by).
+  int half_h = flapBounds.size.h / 2;
+  for (int step = 0; step <= FLAP_GEOMETRY_STEPS; ++step) {
+    int progress = step * FLAP_GEOMETRY_STEP_SIZE;
+    progress = progress > ANIMATION_NORMALIZED_MAX ? ANIMATION_NORMALIZED_MAX : progress;
+    int flap_h = progress - ANIMATION_NORMALIZED_MAX / 2;
+    flap_h = flap_h < 0 ? -flap_h : flap_h;
+    flap_h = (flap_h * flapBounds.size.h) / ANIMATION_NORMALIZED_MAX; // Dammit why no abs().
+    steps[step].flap_h = flap_h;
+    steps[step].flap_corner_rad = half_h > 0 ? (flap_h * FLAP_CORNER_RADIUS) / half_h : 0; // You'd need some seriously good eyesight to notice this changing.
+  }
+}
+
+static void split_flap_layer_build_geometry(SplitFlapLayer* split_layer, GRect flapBounds) {
+  split_flap_build_geometry(split_layer->geometry_steps, flapBounds);
+  split_layer->geometry_flap_h = flapBounds.size.h;
+}
+
+#ifdef SPLIT_FLAP_STATS
+void split_flap_layer_log_stats(SplitFlapLayer* split_layer);
+
+static void split_flap_layer_stats_flip_done(SplitFlapLayer* split_layer, bool finished) {
+  SplitFlapLayerStats* stats = &split_layer->stats;
+  if (finished) {
+    stats->flips++;
+  } else {
+    stats->interrupted_flips++;
+  }
+  stats->last_flip_frames = split_layer->stats_flip_frames;
+  split_layer->stats_flip_frames = 0;
+  if (split_layer->stats_log_interval && (stats->flips + stats->interrupted_flips) % split_layer->stats_log_interval == 0) {
+    split_flap_layer_log_stats(split_layer);
+  }
+}
+#endif
+
+// Whole laps end up where they started, so only keep what's left of the queue after them. It still goes the way the button said, though.
+static void split_flap_layer_fold_queue(SplitFlapLayer* split_layer) {
+  int32_t num_pages = split_layer->num_pages;
+  split_layer->flip_queue_delta = num_pages ? split_layer->flip_queue_delta % num_pages : 0;
+}
+
+static void split_flap_layer_finish_flip(SplitFlapLayer* split_layer, bool finished) {
+  uint32_t old_page_idx = split_layer->current_page;
+#ifdef SPLIT_FLAP_STATS
+  split_flap_layer_stats_flip_done(split_layer, finished);
+#endif
+  split_flap_layer_fold_queue(split_layer);
+  // Anything still queued only carries on if this flip made it to the end.
+  bool more_queued = finished && split_layer->flip_queue_delta != 0;
+  if (!more_queued) {
+    split_layer->flip_queue_delta = 0;
+  }
+  // Finish setting the visibility + update current_page.
+  split_flap_layer_show_page(split_layer, split_layer->anim_appearing_page);
+  // Reset the bounds on both layers - the stopped handler runs before the last frame's drawn, so the new page is still cut down to wherever the last one put it.
+  split_flap_page_layer_setup(split_layer, split_flap_layer_get_page(split_layer, split_layer->anim_disappearing_page));
+  // Snapshots are only ever taken of pages at rest (or drawn as they would be), so its snapshot, if it has one, is still good.
+  split_flap_page_layer_setup(split_layer, split_flap_layer_get_page(split_layer, split_layer->anim_appearing_page));
+  layer_mark_dirty(split_layer->layer);
+
+  // Call callbacks - once per page, or once the queue runs dry.
+  if (split_layer->flip_queue_batch_callbacks) {
+    if (!more_queued) {
+      split_flap_layer_notify_page_changed(split_layer, split_layer->flip_batch_start_page, split_layer->current_page);
+    }
+  } else {
+    split_flap_layer_notify_page_changed(split_layer, old_page_idx, split_layer->current_page);
+  }
+
+  if (more_queued) {
+    split_flap_layer_flip_next_queued(split_layer);
+  }
 }
 
 static void split_flap_animation_cleanup(Animation *animation, bool finished, void *context) {
-  SplitFlapLayer* split_layer = (SplitFlapLayer*)context;
-  // Finish setting the visibility + call callbacks + update current_page.
-  split_flap_layer_set_current_page(split_layer, split_layer->anim_appearing_page, false);
-  // Reset the bounds on the old layer.
-  split_flap_page_layer_setup(split_layer, &split_layer->pages[split_layer->anim_disappearing_page]);
+  split_flap_layer_finish_flip((SplitFlapLayer*)context, finished);
 }
 
 static void split_flap_animation_update(Animation* animation, const uint32_t time_normal) {
   SplitFlapLayer* split_layer = (SplitFlapLayer*)animation_get_context(animation);
-  // Make the animation look cool.
-  split_layer->anim_progress = animation_timing_function_ease_in_out(time_normal);
+#ifdef SPLIT_FLAP_STATS
+  // Each tick should move the animation on by about a frame - any further and the firmware skipped some.
+  if (time_normal > split_layer->stats_last_time_normal) {
+    uint32_t elapsed_ms = (time_normal - split_layer->stats_last_time_normal) * split_layer->stats_anim_duration / ANIMATION_NORMALIZED_MAX;
+    if (elapsed_ms > (uint32_t)FLAP_STATS_FRAME_MS * 3 / 2) {
+      split_layer->stats.dropped_frames += (elapsed_ms + FLAP_STATS_FRAME_MS / 2) / FLAP_STATS_FRAME_MS - 1;
+    }
+  }
+  split_layer->stats_last_time_normal = time_normal;
+#endif
+  uint32_t last_step = split_layer->anim_step;
+  split_flap_layer_set_progress(split_layer, time_normal);
+  if (split_layer->governor_enabled && split_layer->anim_step == last_step) {
+    // Nothing would move, so don't bother drawing it.
+    return;
+  }
   // Invalidate background layer, which is what really implements the animation.
   layer_mark_dirty(split_layer->layer);
 }
@@ -76,140 +345,699 @@ int32_t split_flap_layer_get_current_page(SplitFlapLayer* split_layer) {
   return split_layer->current_page;
 }
 
+// Only true of flips the layer runs itself.
+static bool split_flap_layer_is_animating(SplitFlapLayer* split_layer) {
+  return split_layer->anim && animation_is_scheduled(split_layer->anim);
+}
+
+static bool split_flap_layer_is_flipping(SplitFlapLayer* split_layer) {
+  return split_layer->external_flip || split_flap_layer_is_animating(split_layer);
+}
+
+static bool split_flap_layer_flip_direction(SplitFlapLayer* split_layer, uint32_t page_idx) {
+  // The extra convolution is required for proper-feeling wraparound (i.e. the direction it flips always corresponds to the button you press).
+  // And, it's about the only phsically accurate part of this entire affair.
+  return (!(page_idx == split_layer->num_pages - 1 && split_layer->current_page == 0) && page_idx > split_layer->current_page) || (page_idx == 0 && split_layer->current_page == split_layer->num_pages - 1);
+}
+
+static const AnimationImplementation split_flap_animation_implementation = {
+  .setup = NULL,
+  .update = split_flap_animation_update,
+  .teardown = NULL
+};
+
+static void split_flap_layer_prepare_flip(SplitFlapLayer* split_layer, uint32_t page_idx, bool forward) {
+  split_layer->anim_forward = forward;
+  split_layer->anim_appearing_page = page_idx;
+  split_layer->anim_disappearing_page = split_layer->current_page;
+  // The disappearing page is current, so it's bound already - bind the appearing one now, so drawing the flip only has to look them up.
+  split_flap_layer_get_page(split_layer, page_idx);
+  split_layer->anim_progress = 0;
+  split_layer->anim_step = 0;
+  if (split_layer->governor_enabled) {
+    split_flap_layer_check_battery(split_layer);
+  }
+#ifdef SPLIT_FLAP_STATS
+  split_layer->stats_last_time_normal = 0;
+#endif
+}
+
+static void split_flap_layer_start_flip(SplitFlapLayer* split_layer, uint32_t page_idx, bool forward, uint32_t duration) {
+  split_flap_layer_prepare_flip(split_layer, page_idx, forward);
+  if (!split_layer->anim) {
+    // Made to be flipped from outside, so there's no animation of our own - go straight there.
+    split_flap_layer_finish_flip(split_layer, true);
+    return;
+  }
+  animation_set_duration(split_layer->anim, duration);
+#ifdef SPLIT_FLAP_STATS
+  split_layer->stats_anim_duration = duration;
+#endif
+  animation_schedule(split_layer->anim);
+}
+
+static void split_flap_layer_flip_next_queued(SplitFlapLayer* split_layer) {
+  int32_t pending = split_layer->flip_queue_delta;
+  int32_t direction = pending > 0 ? 1 : -1;
+  int32_t flips = pending * direction;
+  int32_t step = direction;
+  if (flips > FLAP_QUEUE_MAX_FLIPS) {
+    // We're falling behind - fold the extra pages into this flip.
+    step = pending - direction * (FLAP_QUEUE_MAX_FLIPS - 1);
+    flips = FLAP_QUEUE_MAX_FLIPS;
+  }
+  split_layer->flip_queue_delta -= step;
+  // The more there is to get through, the quicker each flip goes.
+  uint32_t duration = FLAP_ANIMATION_DURATION / flips;
+  if (duration < (uint32_t)FLAP_MIN_ANIMATION_DURATION) {
+    duration = FLAP_MIN_ANIMATION_DURATION;
+  }
+  split_flap_layer_start_flip(split_layer, split_flap_layer_wrap_page(split_layer, split_layer->current_page, step), step > 0, duration);
+}
+
 void split_flap_layer_set_current_page(SplitFlapLayer* split_layer, uint32_t page_idx, bool animated) {
-  if (page_idx == split_layer->current_page) return;
-  SplitFlapLayerPage* oldPage = split_layer->pages + split_layer->current_page;
-  SplitFlapLayerPage* newPage = split_layer->pages + page_idx;
+  if (page_idx >= split_layer->num_pages || page_idx == split_layer->current_page) return;
   if (animated) {
-    // The extra convolution is required for proper-feeling wraparound (i.e. the direction it flips always corresponds to the button you press).
-    // And, it's about the only phsically accurate part of this entire affair.
-    split_layer->anim_forward = (!(page_idx == split_layer->num_pages - 1 && split_layer->current_page == 0) && page_idx > split_layer->current_page) || (page_idx == 0 && split_layer->current_page == split_layer->num_pages - 1);
-    split_layer->anim_appearing_page = page_idx;
-    split_layer->anim_disappearing_page = split_layer->current_page;
-
-    if (!split_layer->anim) {
-      split_layer->anim = animation_create();
-      AnimationHandlers callbacks = {
-        .started = NULL,
-        .stopped = split_flap_animation_cleanup
-      };
-      animation_set_handlers(split_layer->anim, callbacks, split_layer);
-
-      split_layer->anim_implementation = malloc(sizeof(AnimationImplementation));
-
-      split_layer->anim_implementation->setup = NULL;
-      split_layer->anim_implementation->update = split_flap_animation_update;
-      split_layer->anim_implementation->teardown = NULL;
-      animation_set_implementation(split_layer->anim, split_layer->anim_implementation);
-
-      animation_set_duration(split_layer->anim, FLAP_ANIMATION_DURATION);
+    if (!split_flap_layer_is_flipping(split_layer)) {
+      split_layer->flip_batch_start_page = split_layer->current_page;
     }
-    animation_schedule(split_layer->anim);
+    split_flap_layer_start_flip(split_layer, page_idx, split_flap_layer_flip_direction(split_layer, page_idx), FLAP_ANIMATION_DURATION);
   } else {
-    layer_set_hidden(oldPage->upperLayer, true);
-    layer_set_hidden(oldPage->lowerLayer, true);
-
-    layer_set_hidden(newPage->upperLayer, false);
-    layer_set_hidden(newPage->lowerLayer, false);
-
-    if (split_layer->callbacks.page_changed) {
-      split_layer->callbacks.page_changed(split_layer, split_layer->current_page, page_idx);
-    }
-    split_layer->current_page = page_idx;
+    uint32_t old_page_idx = split_layer->current_page;
+    split_flap_layer_show_page(split_layer, page_idx);
+    split_flap_layer_notify_page_changed(split_layer, old_page_idx, page_idx);
   }
 }
 
 void split_flap_layer_set_current_page_by_delta(SplitFlapLayer* split_layer, int32_t delta, bool animated) {
   // Special wrapper function that exists mostly to let people page as fast as they want without breaking the animation too badly.
+  if (animated && split_layer->flip_queue_enabled) {
+    if (split_flap_layer_is_flipping(split_layer)) {
+      // Let the current flip finish, the rest will follow straight after.
+      split_layer->flip_queue_delta += delta;
+    } else {
+      split_layer->flip_queue_delta = delta;
+      split_flap_layer_fold_queue(split_layer);
+      if (split_layer->flip_queue_delta) {
+        split_layer->flip_batch_start_page = split_layer->current_page;
+        split_flap_layer_flip_next_queued(split_layer);
+      }
+    }
+    return;
+  }
   int current_idx = split_layer->current_page;
-  if (animated && split_layer->anim && animation_is_scheduled(split_layer->anim)) {
+  if (animated && split_flap_layer_is_animating(split_layer)) {
     current_idx = split_layer->anim_appearing_page;
     animation_unschedule(split_layer->anim);
   }
-  split_flap_layer_set_current_page(split_layer, current_idx + delta >= 0 ? (current_idx + delta) % split_layer->num_pages : -((-delta) % split_layer->num_pages) + split_layer->num_pages + current_idx, animated);
+  split_flap_layer_set_current_page(split_layer, split_flap_layer_wrap_page(split_layer, current_idx, delta), animated);
+}
+
+void split_flap_layer_queue_flip_to(SplitFlapLayer* split_layer, uint32_t page_idx) {
+  // Wherever the queue is going to end up, go from there.
+  uint32_t queue_end = split_layer->current_page;
+  if (split_flap_layer_is_flipping(split_layer)) {
+    queue_end = split_flap_layer_wrap_page(split_layer, split_layer->anim_appearing_page, split_layer->flip_queue_delta);
+  }
+  // There's no button to go by here, so take the shorter way round.
+  int32_t num_pages = split_layer->num_pages;
+  int32_t delta = (int32_t)page_idx - (int32_t)queue_end;
+  if (delta * 2 > num_pages) {
+    delta -= num_pages;
+  } else if (delta * 2 < -num_pages) {
+    delta += num_pages;
+  }
+  split_flap_layer_set_current_page_by_delta(split_layer, delta, true);
+}
+
+void split_flap_layer_set_flip_queue(SplitFlapLayer* split_layer, bool enabled, bool batch_callbacks) {
+  split_layer->flip_queue_enabled = enabled;
+  split_layer->flip_queue_batch_callbacks = enabled && batch_callbacks;
+  if (!enabled) {
+    split_layer->flip_queue_delta = 0;
+  }
+}
+
+// Cut short whatever flip is going on, leaving its new page showing.
+static void split_flap_layer_stop_flip(SplitFlapLayer* split_layer) {
+  if (split_flap_layer_is_animating(split_layer)) {
+    animation_unschedule(split_layer->anim);
+  } else if (split_layer->external_flip) {
+    split_layer->external_flip = false;
+    split_flap_layer_finish_flip(split_layer, false);
+  }
+}
+
+bool split_flap_layer_begin_flip(SplitFlapLayer* split_layer, uint32_t page_idx) {
+  split_flap_layer_stop_flip(split_layer);
+  if (page_idx >= split_layer->num_pages || page_idx == split_layer->current_page) return false;
+  split_layer->flip_batch_start_page = split_layer->current_page;
+  split_flap_layer_prepare_flip(split_layer, page_idx, split_flap_layer_flip_direction(split_layer, page_idx));
+  split_layer->external_flip = true;
+  return true;
+}
+
+void split_flap_layer_set_flip_progress(SplitFlapLayer* split_layer, uint32_t time_normal) {
+  split_flap_layer_set_progress(split_layer, time_normal);
+}
+
+void split_flap_layer_end_flip(SplitFlapLayer* split_layer) {
+  if (!split_layer->external_flip) return;
+  split_layer->external_flip = false;
+  split_flap_layer_finish_flip(split_layer, true);
+}
+
+// Copies pixels between 1-bit bitmaps (there's no way to render into anything but the framebuffer, so this is how we grab things out of it).
+// Whatever of src_rect is off the edge of src (a control hanging off the screen, say) is left alone in dest.
+void split_flap_bitmap_copy(GBitmap* dest, GPoint dest_origin, const GBitmap* src, GRect src_rect) {
+  for (int y = 0; y < src_rect.size.h; ++y) {
+    int src_y = src_rect.origin.y + y;
+    if (src_y < src->bounds.origin.y || src_y >= src->bounds.origin.y + src->bounds.size.h) continue;
+    const uint8_t* src_row = (const uint8_t*)src->addr + src_y * src->row_size_bytes;
+    uint8_t* dest_row = (uint8_t*)dest->addr + (dest_origin.y + y) * dest->row_size_bytes;
+    for (int x = 0; x < src_rect.size.w; ++x) {
+      int src_x = src_rect.origin.x + x;
+      int dest_x = dest_origin.x + x;
+      if (src_x < src->bounds.origin.x || src_x >= src->bounds.origin.x + src->bounds.size.w) continue;
+      if (src_row[src_x / 8] & (1 << (src_x % 8))) {
+        dest_row[dest_x / 8] |= 1 << (dest_x % 8);
+      } else {
+        dest_row[dest_x / 8] &= ~(1 << (dest_x % 8));
+      }
+    }
+  }
+}
+
+// Points bitmap at our own pixels, in the framebuffer's format (there's no way to make one from scratch).
+void split_flap_bitmap_init(GBitmap* bitmap, GContext* ctx, void* pixels, GSize size, bool heap_allocated) {
+  memcpy(bitmap, ctx, sizeof(GBitmap));
+  bitmap->addr = pixels;
+  bitmap->row_size_bytes = ((size.w + 31) / 32) * 4; // Rows are word-aligned.
+  bitmap->bounds = GRect(0, 0, size.w, size.h);
+  bitmap->is_heap_allocated = heap_allocated;
+}
+
+// Allocated ahead of time so drawing doesn't have to - split_flap_bitmap_init sorts the format out once there's a GContext to hand.
+static GBitmap* split_flap_bitmap_create(GSize size) {
+  GBitmap* bitmap = malloc(sizeof(GBitmap));
+  if (!bitmap) return NULL;
+  memset(bitmap, 0, sizeof(GBitmap));
+  bitmap->row_size_bytes = ((size.w + 31) / 32) * 4;
+  bitmap->bounds = GRect(0, 0, size.w, size.h);
+  bitmap->addr = malloc(bitmap->row_size_bytes * size.h);
+  if (!bitmap->addr) {
+    free(bitmap);
+    return NULL;
+  }
+  bitmap->is_heap_allocated = true;
+  return bitmap;
+}
+
+// The area covered by each rounded corner of the flap (clockwise from the top-left).
+GRect split_flap_corner_rect(GRect flapBounds, int corner) {
+  int right = flapBounds.origin.x + flapBounds.size.w - FLAP_CORNER_RADIUS;
+  int bottom = flapBounds.origin.y + flapBounds.size.h - FLAP_CORNER_RADIUS;
+  return GRect(corner == 1 || corner == 2 ? right : flapBounds.origin.x, corner >= 2 ? bottom : flapBounds.origin.y, FLAP_CORNER_RADIUS, FLAP_CORNER_RADIUS);
+}
+
+// Where each corner lives in the corner mask bitmap.
+GRect split_flap_corner_tile(int corner) {
+  return GRect(corner == 1 || corner == 2 ? FLAP_CORNER_RADIUS : 0, corner >= 2 ? FLAP_CORNER_RADIUS : 0, FLAP_CORNER_RADIUS, FLAP_CORNER_RADIUS);
+}
+
+// Where the control's top-left corner is in the framebuffer.
+static GPoint split_flap_layer_get_screen_origin(SplitFlapLayer* split_layer) {
+  GRect frame = layer_get_frame(split_layer->layer);
+  return GPoint(frame.origin.x + split_layer->screen_offset.x, frame.origin.y + split_layer->screen_offset.y);
+}
+
+static bool split_flap_page_has_snapshot_buffers(SplitFlapLayerPage* page, GSize size) {
+  return page->upperSnapshot && page->lowerSnapshot && page->upperSnapshot->bounds.size.w == size.w && page->upperSnapshot->bounds.size.h == size.h;
+}
+
+static bool split_flap_page_has_snapshot(SplitFlapLayerPage* page, GSize size) {
+  return page->snapshotValid && split_flap_page_has_snapshot_buffers(page, size);
+}
+
+void split_flap_page_discard_snapshot(SplitFlapLayerPage* page) {
+  if (page->upperSnapshot) {
+    gbitmap_destroy(page->upperSnapshot);
+    page->upperSnapshot = NULL;
+  }
+  if (page->lowerSnapshot) {
+    gbitmap_destroy(page->lowerSnapshot);
+    page->lowerSnapshot = NULL;
+  }
+  page->snapshotValid = false;
+}
+
+// Make room for a page's snapshot, ahead of it being captured.
+bool split_flap_page_alloc_snapshot(SplitFlapLayerPage* page, GSize size) {
+  if (split_flap_page_has_snapshot_buffers(page, size)) return true;
+  split_flap_page_discard_snapshot(page);
+  page->upperSnapshot = split_flap_bitmap_create(size);
+  page->lowerSnapshot = split_flap_bitmap_create(size);
+  if (!page->upperSnapshot || !page->lowerSnapshot) {
+    // Not enough heap - this page will just have to flip the slow way.
+    split_flap_page_discard_snapshot(page);
+    return false;
+  }
+  return true;
+}
+
+// Either the pages passed to split_flap_layer_set_pages, or the data source's pool.
+static SplitFlapLayerPage* split_flap_layer_get_pages(SplitFlapLayer* split_layer, uint32_t* num_pages) {
+  if (split_layer->data_source.configure_page) {
+    *num_pages = SPLIT_FLAP_PAGE_POOL_SIZE;
+    return split_layer->page_pool;
+  }
+  *num_pages = split_layer->pages ? split_layer->num_pages : 0;
+  return split_layer->pages;
+}
+
+static void split_flap_layer_alloc_snapshots(SplitFlapLayer* split_layer) {
+  if (!split_layer->snapshot_mode) return;
+  GRect flapBounds = grect_crop(layer_get_bounds(split_layer->layer), FLAP_INSET);
+  uint32_t num_pages;
+  SplitFlapLayerPage* pages = split_flap_layer_get_pages(split_layer, &num_pages);
+  for (uint i = 0; i < num_pages; ++i) {
+    split_flap_page_alloc_snapshot(&pages[i], GSize(flapBounds.size.w, flapBounds.size.h / 2));
+  }
+}
+
+static bool split_flap_layer_page_in_use(SplitFlapLayer* split_layer, uint32_t page_idx) {
+  if (page_idx == split_layer->current_page) return true;
+  return split_flap_layer_is_flipping(split_layer) && (page_idx == split_layer->anim_appearing_page || page_idx == split_layer->anim_disappearing_page);
+}
+
+// The page showing page_idx, if there is one already - unlike split_flap_layer_get_page, this never binds a pool page, so it's what drawing uses.
+static SplitFlapLayerPage* split_flap_layer_find_page(SplitFlapLayer* split_layer, uint32_t page_idx) {
+  if (page_idx >= split_layer->num_pages) return NULL;
+  if (!split_layer->data_source.configure_page) {
+    return split_layer->pages + page_idx;
+  }
+  for (int i = 0; i < SPLIT_FLAP_PAGE_POOL_SIZE; ++i) {
+    if (split_layer->page_pool_idx[i] == page_idx) {
+      return &split_layer->page_pool[i];
+    }
+  }
+  return NULL;
+}
+
+// Pages come either from the array passed to split_flap_layer_set_pages, or from the pool, bound to the data source's page on demand. That runs
+// configure_page, so it's only done when a page becomes current or a flip starts - never while drawing.
+static SplitFlapLayerPage* split_flap_layer_get_page(SplitFlapLayer* split_layer, uint32_t page_idx) {
+  if (!split_layer->data_source.configure_page) {
+    return split_layer->pages + page_idx;
+  }
+  for (int i = 0; i < SPLIT_FLAP_PAGE_POOL_SIZE; ++i) {
+    if (split_layer->page_pool_idx[i] == page_idx) {
+      return &split_layer->page_pool[i];
+    }
+  }
+  // Not bound yet - use an empty page if there is one, otherwise recycle one that's not on screen.
+  int slot = -1;
+  for (int i = 0; i < SPLIT_FLAP_PAGE_POOL_SIZE && slot < 0; ++i) {
+    if (split_layer->page_pool_idx[i] == SPLIT_FLAP_PAGE_UNBOUND) slot = i;
+  }
+  for (int i = 0; i < SPLIT_FLAP_PAGE_POOL_SIZE && slot < 0; ++i) {
+    if (!split_flap_layer_page_in_use(split_layer, split_layer->page_pool_idx[i])) slot = i;
+  }
+  SplitFlapLayerPage* page = &split_layer->page_pool[slot];
+  split_layer->page_pool_idx[slot] = page_idx;
+  page->snapshotValid = false;
+  layer_set_hidden(page->upperLayer, true);
+  layer_set_hidden(page->lowerLayer, true);
+  split_flap_page_layer_setup(split_layer, page);
+  split_layer->data_source.configure_page(split_layer, page, page_idx, split_layer->data_source_context);
+  layer_mark_dirty(page->upperLayer);
+  layer_mark_dirty(page->lowerLayer);
+  return page;
+}
+
+// The four corners of the flap, as the background leaves them, for masking the pages' corners off.
+static void split_flap_layer_capture_corner_mask(SplitFlapLayer* split_layer, GContext* ctx, GRect flapBounds) {
+  split_flap_bitmap_init(&split_layer->corner_mask, ctx, split_layer->corner_mask_pixels, GSize(FLAP_CORNER_RADIUS * 2, FLAP_CORNER_RADIUS * 2), false);
+  GPoint origin = split_flap_layer_get_screen_origin(split_layer);
+  for (int i = 0; i < 4; ++i) {
+    GRect corner = split_flap_corner_rect(flapBounds, i);
+    GRect tile = split_flap_corner_tile(i);
+    split_flap_bitmap_copy(&split_layer->corner_mask, tile.origin, (GBitmap*)ctx, GRect(origin.x + corner.origin.x, origin.y + corner.origin.y, corner.size.w, corner.size.h));
+  }
+  split_layer->corner_mask_ready = true;
+}
+
+// Whiten whatever's outside the rounded corners in a snapshot of the half starting at half_y. Those pixels are the background's,
+// not the page's, and a page layer leaves them alone - so should the snapshot when it's blitted onto the flap mid-flip.
+static void split_flap_layer_clear_snapshot_corners(SplitFlapLayer* split_layer, GBitmap* snapshot, GRect flapBounds, int half_y) {
+  for (int i = 0; i < 4; ++i) {
+    GRect corner = split_flap_corner_rect(flapBounds, i);
+    GRect tile = split_flap_corner_tile(i);
+    for (int y = 0; y < corner.size.h; ++y) {
+      int dest_y = corner.origin.y - half_y + y;
+      if (dest_y < 0 || dest_y >= snapshot->bounds.size.h) continue;
+      const uint8_t* mask_row = (const uint8_t*)split_layer->corner_mask.addr + (tile.origin.y + y) * split_layer->corner_mask.row_size_bytes;
+      uint8_t* dest_row = (uint8_t*)snapshot->addr + dest_y * snapshot->row_size_bytes;
+      for (int x = 0; x < corner.size.w; ++x) {
+        int mask_x = tile.origin.x + x;
+        int dest_x = corner.origin.x - flapBounds.origin.x + x;
+        if (!(mask_row[mask_x / 8] & (1 << (mask_x % 8)))) {
+          dest_row[dest_x / 8] |= 1 << (dest_x % 8);
+        }
+      }
+    }
+  }
+}
+
+// Grab what a page just drew, so flips don't need to run its update_procs again.
+static void split_flap_layer_capture_snapshot(SplitFlapLayer* split_layer, GContext* ctx, SplitFlapLayerPage* page) {
+  GRect flapBounds = grect_crop(layer_get_bounds(split_layer->layer), FLAP_INSET);
+  GSize half_size = GSize(flapBounds.size.w, flapBounds.size.h / 2);
+  GPoint origin = split_flap_layer_get_screen_origin(split_layer);
+  // The buffers are made when the pages are set or the layer resized, never here - if they're missing (or we've been resized some
+  // other way), the page just keeps drawing the slow way.
+  if (!split_flap_page_has_snapshot_buffers(page, half_size)) return;
+  split_flap_bitmap_init(page->upperSnapshot, ctx, page->upperSnapshot->addr, half_size, true);
+  split_flap_bitmap_init(page->lowerSnapshot, ctx, page->lowerSnapshot->addr, half_size, true);
+  GRect upper = GRect(origin.x + flapBounds.origin.x, origin.y + flapBounds.origin.y, half_size.w, half_size.h);
+  GRect lower = GRect(upper.origin.x, upper.origin.y + flapBounds.size.h / 2, half_size.w, half_size.h);
+  split_flap_bitmap_copy(page->upperSnapshot, GPointZero, (GBitmap*)ctx, upper);
+  split_flap_bitmap_copy(page->lowerSnapshot, GPointZero, (GBitmap*)ctx, lower);
+  if (split_layer->corner_mask_ready) {
+    split_flap_layer_clear_snapshot_corners(split_layer, page->upperSnapshot, flapBounds, flapBounds.origin.y);
+    split_flap_layer_clear_snapshot_corners(split_layer, page->lowerSnapshot, flapBounds, flapBounds.origin.y + flapBounds.size.h / 2);
+  }
+  page->snapshotValid = true;
+}
+
+static void split_flap_text_draw(SplitFlapLayer* split_layer, GContext* ctx, uint32_t page_idx, GRect box) {
+  if (page_idx >= split_layer->num_texts) return;
+  const char* text = split_layer->texts[page_idx];
+  // Centred on the split, so it gets cut in half like the real thing.
+  GSize size = graphics_text_layout_get_max_used_size(ctx, text, split_layer->text_font, box, GTextOverflowModeWordWrap, split_layer->text_alignment, NULL);
+  graphics_context_set_text_color(ctx, FLAP_FOREGROUND_COLOR);
+  graphics_draw_text(ctx, text, split_layer->text_font, GRect(box.origin.x, box.origin.y + (box.size.h - size.h) / 2, box.size.w, size.h), GTextOverflowModeWordWrap, split_layer->text_alignment, NULL);
+}
+
+static void split_flap_text_page_update_proc(Layer* layer, GContext* ctx) {
+  SplitFlapLayer* split_layer = *(SplitFlapLayer**)layer_get_data(layer);
+  GRect flapBounds = grect_crop(layer_get_bounds(split_layer->layer), FLAP_INSET);
+  for (int i = 0; i < SPLIT_FLAP_PAGE_POOL_SIZE; ++i) {
+    SplitFlapLayerPage* page = &split_layer->page_pool[i];
+    if (layer == page->upperLayer || layer == page->lowerLayer) {
+      // Both halves draw the whole page, the lower one shifted up so only its half shows.
+      int y = layer == page->lowerLayer ? -flapBounds.size.h / 2 : 0;
+      split_flap_text_draw(split_layer, ctx, split_layer->page_pool_idx[i], GRect(0, y, flapBounds.size.w, flapBounds.size.h));
+      return;
+    }
+  }
+}
+
+static uint32_t split_flap_text_get_num_pages(SplitFlapLayer* split_layer, void* context) {
+  return split_layer->num_texts;
+}
+
+static void split_flap_text_configure_page(SplitFlapLayer* split_layer, SplitFlapLayerPage* page, uint32_t page_idx, void* context) {
+  layer_set_update_proc(page->upperLayer, split_flap_text_page_update_proc);
+  layer_set_update_proc(page->lowerLayer, split_flap_text_page_update_proc);
+}
+
+// Draw a text page straight into the framebuffer, just as it'd look when showing, and snapshot it. Whatever's drawn afterwards covers it up.
+static bool split_flap_layer_prerender_text_page(SplitFlapLayer* split_layer, GContext* ctx, GRect bounds, uint32_t page_idx) {
+  GRect flapBounds = grect_crop(bounds, FLAP_INSET);
+  SplitFlapLayerPage* page = split_flap_layer_find_page(split_layer, page_idx);
+  GSize half_size = GSize(flapBounds.size.w, flapBounds.size.h / 2);
+  // No buffers to snapshot it into, so there's no point drawing it.
+  if (!page || !split_flap_page_has_snapshot_buffers(page, half_size) || split_flap_page_has_snapshot(page, half_size)) return false;
+  int split_y = flapBounds.origin.y + flapBounds.size.h / 2;
+  graphics_context_set_fill_color(ctx, FLAP_BACKGROUND_COLOR);
+  split_flap_fill_rect(split_layer, ctx, flapBounds, FLAP_CORNER_RADIUS, GCornersAll);
+  if (!split_layer->corner_mask_ready) {
+    // The snapshot needs the corners, and this is the first time the background's been drawn.
+    split_flap_layer_capture_corner_mask(split_layer, ctx, flapBounds);
+  }
+  graphics_context_set_fill_color(ctx, FLAP_FOREGROUND_COLOR);
+  split_flap_fill_rect(split_layer, ctx, GRect(bounds.origin.x, split_y - FLAP_SPLIT_HEIGHT / 2, bounds.size.w, FLAP_SPLIT_HEIGHT), 0, 0);
+  split_flap_text_draw(split_layer, ctx, page_idx, flapBounds);
+  split_flap_layer_capture_snapshot(split_layer, ctx, page);
+  return true;
+}
+
+static void split_flap_layer_place_piece(SplitFlapLayer* split_layer, GRect flapBounds, SplitFlapPiece* piece) {
+  if (piece->lower) {
+    split_flap_set_page_frame(split_layer, piece->page->lowerLayer, piece->frame);
+    split_flap_set_page_bounds(split_layer, piece->page->lowerLayer, GRect(0, -piece->src_y, flapBounds.size.w, flapBounds.size.h));
+  } else {
+    split_flap_set_page_frame(split_layer, piece->page->upperLayer, piece->frame);
+  }
+}
+
+static void split_flap_layer_draw_piece(SplitFlapLayer* split_layer, GContext* ctx, SplitFlapPiece* piece) {
+  if (piece->frame.size.h <= 0) return;
+  // A stack copy with narrower bounds works just like a sub-bitmap.
+  GBitmap view = *(piece->lower ? piece->page->lowerSnapshot : piece->page->upperSnapshot);
+  view.bounds = GRect(0, piece->src_y, view.bounds.size.w, piece->frame.size.h);
+  view.is_heap_allocated = false;
+  split_flap_draw_bitmap(split_layer, ctx, &view, piece->frame);
+}
+
+// Where the flap and the slices of the two pages go, anim_step into a flip from oldPage to newPage.
+void split_flap_get_flip_geometry(const SplitFlapGeometryStep* steps, uint32_t anim_step, bool forward, GRect flapBounds, SplitFlapLayerPage* oldPage, SplitFlapLayerPage* newPage, SplitFlapFlipGeometry* geometry) {
+  int split_y = flapBounds.origin.y + flapBounds.size.h / 2;
+  int split_h = FLAP_SPLIT_HEIGHT;
+  const SplitFlapGeometryStep* step = &steps[anim_step];
+  // All the positioning values for our animation.
+  // (under the entirely safe assumption that ANIMATION_NORMALIZED_MIN will forever be 0)
+  bool flap_up = (anim_step > FLAP_GEOMETRY_STEPS / 2) ^ forward;
+  bool finished_half = flap_up ^ forward;
+  int full_flap_h = flapBounds.size.h / 2; // The max height of the flap (occurs at the beginning and end of animation).
+  int flap_h = step->flap_h; // How tall the flap is at this point in time.
+  int flap_h_inv = full_flap_h - flap_h; // The height of the space "underneath" the flap.
+
+  geometry->flap_up = flap_up;
+  geometry->finished_half = finished_half;
+  geometry->flap_rect = GRect(flapBounds.origin.x, flap_up ? split_y - flap_h : split_y + split_h / 2, flapBounds.size.w, flap_h - split_h / 2);
+  geometry->flap_corner_rad = step->flap_corner_rad;
+
+  // Convenience values for when we're clipping layers.
+  int flap_pre_half_h_inv = !finished_half ? flap_h_inv : full_flap_h;
+  int flap_pre_half_h = !finished_half ? flap_h : 0;
+  int flap_post_half_h_inv = !finished_half ? full_flap_h : flap_h_inv;
+  int flap_post_half_h = !finished_half ? 0 : flap_h;
+
+  // Work out which slice of which page half goes where.
+  SplitFlapPiece* pieces = geometry->pieces;
+  if (forward) {
+    // Reveal the first half of the new page
+    pieces[0] = (SplitFlapPiece){newPage, false, GRect(flapBounds.origin.x, flapBounds.origin.y, flapBounds.size.w, flap_pre_half_h_inv), 0};
+    pieces[1] = (SplitFlapPiece){oldPage, false, GRect(flapBounds.origin.x, flapBounds.origin.y + flap_pre_half_h_inv, flapBounds.size.w, flap_pre_half_h), 0};
+    // Reveal the second half
+    pieces[2] = (SplitFlapPiece){newPage, true, GRect(flapBounds.origin.x, split_y, flapBounds.size.w, flap_post_half_h), flap_post_half_h_inv};
+    pieces[3] = (SplitFlapPiece){oldPage, true, GRect(flapBounds.origin.x, split_y + flap_post_half_h, flapBounds.size.w, flap_post_half_h_inv), flap_post_half_h};
+  } else {
+    pieces[0] = (SplitFlapPiece){oldPage, true, GRect(flapBounds.origin.x, split_y, flapBounds.size.w, flap_pre_half_h), flap_pre_half_h_inv};
+    pieces[1] = (SplitFlapPiece){newPage, true, GRect(flapBounds.origin.x, split_y + flap_pre_half_h, flapBounds.size.w, flap_pre_half_h_inv), flap_pre_half_h};
+    pieces[2] = (SplitFlapPiece){oldPage, false, GRect(flapBounds.origin.x, flapBounds.origin.y, flapBounds.size.w, flap_post_half_h_inv), 0};
+    pieces[3] = (SplitFlapPiece){newPage, false, GRect(flapBounds.origin.x, flapBounds.origin.y + flap_post_half_h_inv, flapBounds.size.w, flap_post_half_h), 0};
+  }
+}
+
+static void split_flap_layer_get_flip_geometry(SplitFlapLayer* split_layer, GRect flapBounds, SplitFlapFlipGeometry* geometry) {
+  if (split_layer->geometry_flap_h != flapBounds.size.h) {
+    // We've been resized.
+    split_flap_layer_build_geometry(split_layer, flapBounds);
+  }
+  SplitFlapLayerPage* oldPage = split_flap_layer_find_page(split_layer, split_layer->anim_disappearing_page);
+  SplitFlapLayerPage* newPage = split_flap_layer_find_page(split_layer, split_layer->anim_appearing_page);
+  split_flap_get_flip_geometry(split_layer->geometry_steps, split_layer->anim_step, split_layer->anim_forward, flapBounds, oldPage, newPage, geometry);
+}
+
+static void split_flap_band_add(int* top, int* bottom, int y0, int y1) {
+  if (y0 >= y1) return;
+  if (y0 < *top) *top = y0;
+  if (y1 > *bottom) *bottom = y1;
+}
+
+// The rows that differ between two frames of the same flip.
+static void split_flap_layer_get_damage(SplitFlapFlipGeometry* prev, SplitFlapFlipGeometry* cur, int* top, int* bottom) {
+  *top = INT16_MAX;
+  *bottom = INT16_MIN;
+  // The old flap border has to go, the new one has to be drawn.
+  GRect prev_border = grect_crop(prev->flap_rect, -FLAP_SPLIT_HEIGHT);
+  GRect cur_border = grect_crop(cur->flap_rect, -FLAP_SPLIT_HEIGHT);
+  split_flap_band_add(top, bottom, prev_border.origin.y, prev_border.origin.y + prev_border.size.h);
+  split_flap_band_add(top, bottom, cur_border.origin.y, cur_border.origin.y + cur_border.size.h);
+  for (int i = 0; i < 4; ++i) {
+    SplitFlapPiece* p = &prev->pieces[i];
+    SplitFlapPiece* c = &cur->pieces[i];
+    int p0 = p->frame.origin.y, p1 = p0 + p->frame.size.h;
+    int c0 = c->frame.origin.y, c1 = c0 + c->frame.size.h;
+    if (p->page == c->page && p->lower == c->lower && p0 - p->src_y == c0 - c->src_y) {
+      // Same content in the same place, only the ends moved.
+      split_flap_band_add(top, bottom, p0 < c0 ? p0 : c0, p0 < c0 ? c0 : p0);
+      split_flap_band_add(top, bottom, p1 < c1 ? p1 : c1, p1 < c1 ? c1 : p1);
+    } else {
+      split_flap_band_add(top, bottom, p0, p1);
+      split_flap_band_add(top, bottom, c0, c1);
+    }
+  }
+}
+
+static GRect split_flap_clip_rows(GRect rect, int top, int bottom) {
+  int y0 = rect.origin.y > top ? rect.origin.y : top;
+  int y1 = rect.origin.y + rect.size.h < bottom ? rect.origin.y + rect.size.h : bottom;
+  return GRect(rect.origin.x, y0, rect.size.w, y1 > y0 ? y1 - y0 : 0);
 }
 
 static void split_flap_layer_draw_background(Layer *layer, GContext* ctx) {
   GRect bounds = layer_get_bounds(layer);
   GRect flapBounds = grect_crop(bounds, FLAP_INSET);
   SplitFlapLayer* split_layer = *(SplitFlapLayer**)layer_get_data(layer);
+  bool animating = split_flap_layer_is_flipping(split_layer);
+  if (split_layer->governor_enabled) {
+    split_layer->governor_frame_start_ms = SPLIT_FLAP_CLOCK_MS();
+  }
+#ifdef SPLIT_FLAP_PROFILE
+  // The background is the first thing we draw each frame, the mask the last.
+  split_layer->profile.frame++;
+  split_layer->profile.draw_calls = 0;
+  split_layer->profile.pixels_filled = 0;
+  split_layer->profile.frame_sets = 0;
+  split_layer->profile.bounds_sets = 0;
+  split_layer->profile.empty_layer_draws = 0;
+  split_layer->profile_num_rects = 0;
+  split_layer->profile.animating = animating;
+  split_layer->profile.anim_progress = split_layer->anim_progress;
+  split_layer->profile_start_ms = SPLIT_FLAP_CLOCK_MS();
+#endif
+#ifdef SPLIT_FLAP_STATS
+  split_layer->stats_start_ms = SPLIT_FLAP_CLOCK_MS();
+  if (animating) {
+    split_layer->stats.flip_frames++;
+    split_layer->stats_flip_frames++;
+  }
+#endif
 
   int split_y = flapBounds.origin.y + flapBounds.size.h / 2;
   int split_h = FLAP_SPLIT_HEIGHT;
+
+  SplitFlapFlipGeometry geometry;
+  bool use_snapshots = false;
+  // At rest, a page that's been snapshotted is blitted back rather than having its update_procs run (and its layers drawn) every frame.
+  SplitFlapLayerPage* rest_page = NULL;
+  if (!animating && split_layer->snapshot_mode && split_layer->num_pages) {
+    rest_page = split_flap_layer_find_page(split_layer, split_layer->current_page);
+    bool cached = split_flap_page_has_snapshot(rest_page, GSize(flapBounds.size.w, flapBounds.size.h / 2));
+    layer_set_hidden(rest_page->upperLayer, cached);
+    layer_set_hidden(rest_page->lowerLayer, cached);
+    if (!cached) {
+      rest_page = NULL;
+    }
+  }
+  if (animating) {
+    if (split_layer->snapshot_mode && split_layer->data_source.configure_page == split_flap_text_configure_page) {
+      // Text pages don't need to be shown before they can be snapshotted, so the whole flip can come from snapshots.
+      bool prerendered = split_flap_layer_prerender_text_page(split_layer, ctx, bounds, split_layer->anim_disappearing_page);
+      prerendered |= split_flap_layer_prerender_text_page(split_layer, ctx, bounds, split_layer->anim_appearing_page);
+      if (prerendered) {
+        // That's made a mess of the framebuffer.
+        split_layer->last_flip_valid = false;
+      }
+    }
+    split_flap_layer_get_flip_geometry(split_layer, flapBounds, &geometry);
+    GSize half_size = GSize(flapBounds.size.w, flapBounds.size.h / 2);
+    use_snapshots = split_layer->snapshot_mode &&
+                    split_flap_page_has_snapshot(split_flap_layer_find_page(split_layer, split_layer->anim_disappearing_page), half_size) &&
+                    split_flap_page_has_snapshot(split_flap_layer_find_page(split_layer, split_layer->anim_appearing_page), half_size);
+  }
+
+  // Usually we repaint everything. In incremental mode, a flip drawn from snapshots only repaints the band of rows that changed since the last frame - the rest of the framebuffer still has it.
+  int top = bounds.origin.y;
+  int bottom = bounds.origin.y + bounds.size.h;
+  bool partial = use_snapshots && split_layer->incremental_redraw && split_layer->last_flip_valid && split_layer->corner_mask_ready;
+  if (partial) {
+    split_flap_layer_get_damage(&split_layer->last_flip, &geometry, &top, &bottom);
+  }
+  // The snapshots have the corners cut out already, so a page drawn from one leaves the mask nothing to do.
+  split_layer->damage_top = top;
+  split_layer->damage_bottom = rest_page ? top : bottom;
+  split_layer->last_flip_valid = use_snapshots;
+  if (use_snapshots) {
+    split_layer->last_flip = geometry;
+  }
+
   // The main background
   graphics_context_set_fill_color(ctx, FLAP_BACKGROUND_COLOR);
-  graphics_fill_rect(ctx, flapBounds, 8, GCornersAll);
-  // We capture this now to use for masking later on, since you can't create arbitrary bitmaps :(
-  if (!split_layer->mask_bmp) {
-    split_layer->mask_bmp = malloc(sizeof(GBitmap));
-    memcpy(split_layer->mask_bmp, ctx, sizeof(GBitmap));
-    int sz = split_layer->mask_bmp->bounds.size.h * split_layer->mask_bmp->row_size_bytes;
-    split_layer->mask_bmp->addr = malloc(sz);
-    split_layer->mask_bmp->is_heap_allocated = true;
-    memcpy(split_layer->mask_bmp->addr, ((GBitmap*)ctx)->addr, sz);
+  if (partial) {
+    // The mask puts the rounded corners back.
+    split_flap_fill_rect(split_layer, ctx, split_flap_clip_rows(flapBounds, top, bottom), 0, GCornerNone);
+  } else {
+    split_flap_fill_rect(split_layer, ctx, flapBounds, FLAP_CORNER_RADIUS, GCornersAll);
+  }
+  // We capture the corners now to use for masking later on, since you can't create arbitrary bitmaps :(
+  // Everything else the pages could draw on is inside the flap anyway, so that's all the mask needs.
+  if (!split_layer->corner_mask_ready) {
+    split_flap_layer_capture_corner_mask(split_layer, ctx, flapBounds);
   }
 
   // The split
   graphics_context_set_fill_color(ctx, FLAP_FOREGROUND_COLOR);
-  graphics_fill_rect(ctx, GRect(bounds.origin.x, split_y - split_h / 2, bounds.size.w, split_h), 0, 0);
+  GRect split_rect = split_flap_clip_rows(GRect(bounds.origin.x, split_y - split_h / 2, bounds.size.w, split_h), top, bottom);
+  if (split_rect.size.h > 0) {
+    split_flap_fill_rect(split_layer, ctx, split_rect, 0, 0);
+  }
 
-  // The animation
-  if (split_layer->anim && animation_is_scheduled(split_layer->anim)) {
-    // All the positioning values for our animation.
-    // (under the entirely safe assumption that ANIMATION_NORMALIZED_MIN will forever be 0)
-    bool flap_up = (split_layer->anim_progress > ANIMATION_NORMALIZED_MAX / 2) ^ split_layer->anim_forward; // Is the falling/rising flap above or below the half-way split?
-    bool finished_half = flap_up ^ split_layer->anim_forward; // Are we more than half-way through the animation?
-    int full_flap_h = flapBounds.size.h / 2; // The max height of the flap (occurs at the beginning and end of animation).
-    int flap_h = (split_layer->anim_progress - ANIMATION_NORMALIZED_MAX / 2); // How tall the flap is at this point in time.
-    flap_h = flap_h < 0 ? -flap_h : flap_h;
-    flap_h = (flap_h * flapBounds.size.h) / ANIMATION_NORMALIZED_MAX; // Dammit why no abs().
-    int flap_h_inv = full_flap_h - flap_h; // The height of the space "underneath" the flap.
+  if (rest_page) {
+    // AND-ed in over the flap, like the snapshot pieces of a flip.
+    graphics_context_set_compositing_mode(ctx, GCompOpAnd);
+    split_flap_draw_bitmap(split_layer, ctx, rest_page->upperSnapshot, GRect(flapBounds.origin.x, flapBounds.origin.y, flapBounds.size.w, flapBounds.size.h / 2));
+    split_flap_draw_bitmap(split_layer, ctx, rest_page->lowerSnapshot, GRect(flapBounds.origin.x, split_y, flapBounds.size.w, flapBounds.size.h / 2));
+    graphics_context_set_compositing_mode(ctx, GCompOpAssign);
+  }
 
+  // The animation
+  if (animating) {
     // Draw the flap border in motion
-    GRect flap_rect = GRect(flapBounds.origin.x, flap_up ? split_y - flap_h : split_y + split_h / 2, flapBounds.size.w, flap_up ? flap_h - split_h / 2: flap_h - split_h / 2);
-    int flap_corner_rad = (flap_h * 8) / (flapBounds.size.h / 2); // You'd need some seriously good eyesight to notice this changing.
+    GRect flap_rect = geometry.flap_rect;
+    int flap_corner_rad = geometry.flap_corner_rad;
+    bool flap_up = geometry.flap_up;
+    bool finished_half = geometry.finished_half;
 
     // You can't set a stroke width, so we have to draw then crop then draw again.
-    graphics_fill_rect(ctx, grect_crop(flap_rect, -split_h), flap_corner_rad, flap_up ? GCornersTop : GCornersBottom);
+    split_flap_fill_rect(split_layer, ctx, grect_crop(flap_rect, -split_h), flap_corner_rad, flap_up ? GCornersTop : GCornersBottom);
     graphics_context_set_fill_color(ctx, FLAP_BACKGROUND_COLOR);
-    graphics_fill_rect(ctx, grect_crop(flap_rect, 0), flap_corner_rad == 0 ? 0 : flap_corner_rad - 1, flap_up ? GCornersTop : GCornersBottom);
+    split_flap_fill_rect(split_layer, ctx, grect_crop(flap_rect, 0), flap_corner_rad == 0 ? 0 : flap_corner_rad - 1, flap_up ? GCornersTop : GCornersBottom);
 
     // The pages we'll be working with
-    SplitFlapLayerPage* oldPage = split_layer->pages + split_layer->anim_disappearing_page;
-    SplitFlapLayerPage* newPage = split_layer->pages + split_layer->anim_appearing_page;
-
-    // First, reduce uneeded drawing (calling these repeadedly doesn't do anything too terrible).
-    layer_set_hidden(split_layer->anim_forward ^ !finished_half ? newPage->upperLayer : newPage->lowerLayer, false);
-    layer_set_hidden(split_layer->anim_forward ^ !finished_half ? newPage->upperLayer : newPage->lowerLayer, false);
-    layer_set_hidden(split_layer->anim_forward ? oldPage->upperLayer : oldPage->lowerLayer, finished_half);
-    layer_set_hidden(split_layer->anim_forward ^ !finished_half ? newPage->lowerLayer : newPage->upperLayer, false);
-
-    // Convenience values for when we're clipping layers.
-    int flap_pre_half_h_inv = !finished_half ? flap_h_inv : full_flap_h;
-    int flap_pre_half_h = !finished_half ? flap_h : 0;
-    int flap_post_half_h_inv = !finished_half ? full_flap_h : flap_h_inv;
-    int flap_post_half_h = !finished_half ? 0 : flap_h;
-
-    // Then, clip appropriately. Unfortunately, we don't have the ability to directly specify clipping parameters for drawing, so it involves a lot of screwing around with layers.
-    // Reveal the first half of the new page
-    if (split_layer->anim_forward) {
-      layer_set_frame(newPage->upperLayer, GRect(flapBounds.origin.x, flapBounds.origin.y, flapBounds.size.w, flap_pre_half_h_inv));
-      layer_set_frame(oldPage->upperLayer, GRect(flapBounds.origin.x, flapBounds.origin.y + flap_pre_half_h_inv, flapBounds.size.w, flap_pre_half_h));
-    } else {
-      layer_set_frame(oldPage->lowerLayer, GRect(flapBounds.origin.x, split_y, flapBounds.size.w, flap_pre_half_h));
-      layer_set_bounds(oldPage->lowerLayer, GRect(0, -flap_pre_half_h_inv, flapBounds.size.w, flapBounds.size.h));
-      layer_set_frame(newPage->lowerLayer, GRect(flapBounds.origin.x, split_y + flap_pre_half_h, flapBounds.size.w, flap_pre_half_h_inv));
-      layer_set_bounds(newPage->lowerLayer, GRect(0, -flap_pre_half_h, flapBounds.size.w, flapBounds.size.h));
-    }
-    // Reveal the second half
-    if (split_layer->anim_forward) {
-      layer_set_frame(newPage->lowerLayer, GRect(flapBounds.origin.x, split_y, flapBounds.size.w, flap_post_half_h));
-      layer_set_bounds(newPage->lowerLayer, GRect(0, -flap_post_half_h_inv, flapBounds.size.w, flapBounds.size.h));
-      layer_set_frame(oldPage->lowerLayer, GRect(flapBounds.origin.x, split_y + flap_post_half_h, flapBounds.size.w, flap_post_half_h_inv));
-      layer_set_bounds(oldPage->lowerLayer, GRect(0, -flap_post_half_h, flapBounds.size.w, flapBounds.size.h));
+    SplitFlapLayerPage* oldPage = split_flap_layer_find_page(split_layer, split_layer->anim_disappearing_page);
+    SplitFlapLayerPage* newPage = split_flap_layer_find_page(split_layer, split_layer->anim_appearing_page);
+
+    if (use_snapshots) {
+      // Both pages are cached, so their update_procs can sit this one out.
+      layer_set_hidden(oldPage->upperLayer, true);
+      layer_set_hidden(oldPage->lowerLayer, true);
+      layer_set_hidden(newPage->upperLayer, true);
+      layer_set_hidden(newPage->lowerLayer, true);
+      // AND-ing the snapshots in keeps the flap border visible, just like transparent page layers would.
+      graphics_context_set_compositing_mode(ctx, GCompOpAnd);
+      for (int i = 0; i < 4; ++i) {
+        SplitFlapPiece piece = geometry.pieces[i];
+        GRect clipped = split_flap_clip_rows(piece.frame, top, bottom);
+        piece.src_y += clipped.origin.y - piece.frame.origin.y;
+        piece.frame = clipped;
+        split_flap_layer_draw_piece(split_layer, ctx, &piece);
+      }
+      graphics_context_set_compositing_mode(ctx, GCompOpAssign);
     } else {
-      layer_set_frame(oldPage->upperLayer, GRect(flapBounds.origin.x, flapBounds.origin.y, flapBounds.size.w, flap_post_half_h_inv));
-      layer_set_frame(newPage->upperLayer, GRect(flapBounds.origin.x, flapBounds.origin.y + flap_post_half_h_inv, flapBounds.size.w, flap_post_half_h));
+      // First, reduce uneeded drawing (calling these repeadedly doesn't do anything too terrible).
+      layer_set_hidden(split_layer->anim_forward ^ !finished_half ? newPage->upperLayer : newPage->lowerLayer, false);
+      layer_set_hidden(split_layer->anim_forward ? oldPage->upperLayer : oldPage->lowerLayer, finished_half);
+      layer_set_hidden(split_layer->anim_forward ? oldPage->lowerLayer : oldPage->upperLayer, false);
+      layer_set_hidden(split_layer->anim_forward ^ !finished_half ? newPage->lowerLayer : newPage->upperLayer, false);
+      // Then, clip appropriately. Unfortunately, we don't have the ability to directly specify clipping parameters for drawing, so it involves a lot of screwing around with layers.
+      for (int i = 0; i < 4; ++i) {
+        split_flap_layer_place_piece(split_layer, flapBounds, &geometry.pieces[i]);
+      }
     }
   }
 }
@@ -218,12 +1046,71 @@ static void split_flap_layer_draw_mask(Layer *layer, GContext* ctx) {
   GRect bounds = layer_get_bounds(layer);
   SplitFlapLayer* split_layer = *(SplitFlapLayer**)layer_get_data(layer);
 
+  // We're drawn after the pages, so this is the moment to grab them - before masking, they'll get masked again when they're drawn.
+  if (split_layer->snapshot_mode && split_layer->num_pages && !split_flap_layer_is_flipping(split_layer)) {
+    SplitFlapLayerPage* page = split_flap_layer_find_page(split_layer, split_layer->current_page);
+    GRect flapBounds = grect_crop(layer_get_bounds(split_layer->layer), FLAP_INSET);
+    if (!split_flap_page_has_snapshot(page, GSize(flapBounds.size.w, flapBounds.size.h / 2))) {
+      split_flap_layer_capture_snapshot(split_layer, ctx, page);
+    }
+  }
+
   // "I'll just use compositing operations to do this - no worries!" - Me, 20 minutes ago
   // "Hmm, maybe if I can create a seperate buffer to prepare before compositing onto the screen buffer" - Me, 10 minutes ago
   // "Ha ha silly me thinking there'd be a function to create a bitmap" - Me, 5 minutes ago
-  if (split_layer->mask_bmp) {
+#ifdef SPLIT_FLAP_STATS
+  bool masked = false;
+#endif
+  if (split_layer->corner_mask_ready) {
+    GRect flapBounds = grect_crop(bounds, FLAP_INSET);
     graphics_context_set_compositing_mode(ctx, GCompOpAnd);
-    graphics_draw_bitmap_in_rect(ctx, split_layer->mask_bmp, bounds);
+    for (int i = 0; i < 4; ++i) {
+      GRect corner = split_flap_corner_rect(flapBounds, i);
+      // Corners the background didn't repaint are still masked from before.
+      if (split_flap_clip_rows(corner, split_layer->damage_top, split_layer->damage_bottom).size.h == 0) continue;
+      GBitmap tile = split_layer->corner_mask;
+      tile.bounds = split_flap_corner_tile(i);
+      split_flap_draw_bitmap(split_layer, ctx, &tile, corner);
+#ifdef SPLIT_FLAP_STATS
+      masked = true;
+#endif
+    }
+  }
+#ifdef SPLIT_FLAP_PROFILE
+  split_layer->profile.wall_time_ms = SPLIT_FLAP_CLOCK_MS() - split_layer->profile_start_ms;
+  // The page layers were drawn in between the background and us - whichever of them were visible.
+  if (split_layer->num_pages) {
+    split_flap_profile_count_empty_layers(split_layer, split_flap_layer_find_page(split_layer, split_layer->current_page));
+    if (split_flap_layer_is_flipping(split_layer)) {
+      if (split_layer->anim_disappearing_page != split_layer->current_page) {
+        split_flap_profile_count_empty_layers(split_layer, split_flap_layer_find_page(split_layer, split_layer->anim_disappearing_page));
+      }
+      if (split_layer->anim_appearing_page != split_layer->current_page) {
+        split_flap_profile_count_empty_layers(split_layer, split_flap_layer_find_page(split_layer, split_layer->anim_appearing_page));
+      }
+    }
+  }
+  // What they drew is up to them, so only our own fills and blits count towards the overdraw.
+  split_layer->profile.overdraw_pixels = split_flap_profile_overdraw(split_layer, bounds);
+  GPoint origin = split_flap_layer_get_screen_origin(split_layer);
+  split_layer->profile.checksum = split_flap_profile_checksum((GBitmap*)ctx, GRect(origin.x, origin.y, bounds.size.w, bounds.size.h));
+  if (split_layer->profile_handler) {
+    split_layer->profile_handler(split_layer, &split_layer->profile, split_layer->profile_context);
+  }
+#endif
+#ifdef SPLIT_FLAP_STATS
+  uint32_t frame_ms = SPLIT_FLAP_CLOCK_MS() - split_layer->stats_start_ms;
+  if (masked) {
+    split_layer->stats.mask_redraws++;
+  }
+  split_layer->stats.frames++;
+  split_layer->stats.total_frame_ms += frame_ms;
+  if (frame_ms > split_layer->stats.worst_frame_ms) {
+    split_layer->stats.worst_frame_ms = frame_ms;
+  }
+#endif
+  if (split_layer->governor_enabled && split_flap_layer_is_flipping(split_layer)) {
+    split_flap_layer_govern(split_layer, SPLIT_FLAP_CLOCK_MS() - split_layer->governor_frame_start_ms);
   }
 }
 
@@ -242,24 +1129,68 @@ static void split_flap_click_config_provider(SplitFlapLayer* split_layer) {
   window_single_repeating_click_subscribe(BUTTON_ID_DOWN, 200, split_flap_layer_next_page_click_handler);
 }
 
-SplitFlapLayer* split_flap_layer_create(GRect frame) {
-  SplitFlapLayer* split_layer = malloc(sizeof(SplitFlapLayer));
+// Everything the layer will ever need from the firmware is got here, so flipping never allocates.
+static SplitFlapLayer* split_flap_layer_init_internal(SplitFlapLayerStorage* storage, GRect frame, bool own_animation) {
+  SplitFlapLayer* split_layer = (SplitFlapLayer*)storage;
   memset(split_layer, 0, sizeof(SplitFlapLayer));
   // The Layer struct isn't exposed, so we can't make nice custom controls that can be upcast when appropriate
   // ...and using layer_get_data all the time is stupid.
   split_layer->layer = layer_create_with_data(frame, sizeof(SplitFlapLayer*));
+  // The mask is a child of the main layer, so it lives in its coordinate space.
+  split_layer->mask_layer = layer_create_with_data(GRect(0, 0, frame.size.w, frame.size.h), sizeof(SplitFlapLayer*));
+  if (own_animation) {
+    split_layer->anim = animation_create();
+  }
+  if (!split_layer->layer || !split_layer->mask_layer || (own_animation && !split_layer->anim)) {
+    if (split_layer->layer) layer_destroy(split_layer->layer);
+    if (split_layer->mask_layer) layer_destroy(split_layer->mask_layer);
+    if (split_layer->anim) animation_destroy(split_layer->anim);
+    return NULL;
+  }
   *(SplitFlapLayer**)layer_get_data(split_layer->layer) = split_layer;
-
-  split_layer->mask_layer = layer_create_with_data(frame, sizeof(SplitFlapLayer*));
   *(SplitFlapLayer**)layer_get_data(split_layer->mask_layer) = split_layer;
 
   // Setup framing
   layer_set_update_proc(split_layer->layer, split_flap_layer_draw_background);
   layer_set_update_proc(split_layer->mask_layer, split_flap_layer_draw_mask);
 
+  if (split_layer->anim) {
+    AnimationHandlers callbacks = {
+      .started = NULL,
+      .stopped = split_flap_animation_cleanup
+    };
+    animation_set_handlers(split_layer->anim, callbacks, split_layer);
+    animation_set_implementation(split_layer->anim, &split_flap_animation_implementation);
+  }
+  return split_layer;
+}
+
+static SplitFlapLayer* split_flap_layer_create_internal(GRect frame, bool own_animation) {
+  SplitFlapLayerStorage* storage = malloc(sizeof(SplitFlapLayer));
+  if (!storage) return NULL;
+  SplitFlapLayer* split_layer = split_flap_layer_init_internal(storage, frame, own_animation);
+  if (!split_layer) {
+    free(storage);
+  }
   return split_layer;
 }
 
+SplitFlapLayer* split_flap_layer_init(SplitFlapLayerStorage* storage, GRect frame) {
+  return split_flap_layer_init_internal(storage, frame, true);
+}
+
+SplitFlapLayer* split_flap_layer_init_driven(SplitFlapLayerStorage* storage, GRect frame) {
+  return split_flap_layer_init_internal(storage, frame, false);
+}
+
+SplitFlapLayer* split_flap_layer_create(GRect frame) {
+  return split_flap_layer_create_internal(frame, true);
+}
+
+SplitFlapLayer* split_flap_layer_create_driven(GRect frame) {
+  return split_flap_layer_create_internal(frame, false);
+}
+
 Layer* split_flap_layer_get_layer(SplitFlapLayer* split_layer) {
   return split_layer->layer;
 }
@@ -270,13 +1201,29 @@ void split_flap_set_click_config_onto_window(SplitFlapLayer* split_layer, struct
 
 void split_flap_layer_init_page(SplitFlapLayer* split_layer, SplitFlapLayerPage* page) {
   // No particular reason for these sizes, split_flap_page_layer_setup overwrites them.
-  page->upperLayer = layer_create(GRect(0, 0, 100, 100));
-  page->lowerLayer = layer_create(GRect(0, 0, 100, 100));
+  page->upperLayer = layer_create_with_data(GRect(0, 0, 100, 100), sizeof(SplitFlapLayer*));
+  page->lowerLayer = layer_create_with_data(GRect(0, 0, 100, 100), sizeof(SplitFlapLayer*));
+  // So text pages can find their way back to us.
+  *(SplitFlapLayer**)layer_get_data(page->upperLayer) = split_layer;
+  *(SplitFlapLayer**)layer_get_data(page->lowerLayer) = split_layer;
+  page->upperSnapshot = NULL;
+  page->lowerSnapshot = NULL;
+  page->snapshotValid = false;
   split_flap_page_layer_setup(split_layer, page);
 }
 
+static void split_flap_layer_release_page_pool(SplitFlapLayer* split_layer) {
+  if (!split_layer->data_source.configure_page) return;
+  for (int i = 0; i < SPLIT_FLAP_PAGE_POOL_SIZE; ++i) {
+    split_flap_layer_deinit_page(&split_layer->page_pool[i]);
+  }
+  split_layer->data_source = (SplitFlapLayerDataSource){0};
+}
+
 void split_flap_layer_set_pages(SplitFlapLayer* split_layer, SplitFlapLayerPage* pages, uint32_t num_pages) {
-  bool first_use = split_layer->pages != NULL;
+  // Any flip has to end while the pages it's between are still around.
+  split_flap_layer_stop_flip(split_layer);
+  split_flap_layer_release_page_pool(split_layer);
   split_layer->pages = pages;
   split_layer->num_pages = num_pages;
 
@@ -291,30 +1238,194 @@ void split_flap_layer_set_pages(SplitFlapLayer* split_layer, SplitFlapLayerPage*
   }
   // Adding this as a child again will push it to the top of the z order
   layer_add_child(split_layer->layer, split_layer->mask_layer);
+  split_flap_layer_build_geometry(split_layer, grect_crop(layer_get_bounds(split_layer->layer), FLAP_INSET));
+  split_flap_layer_alloc_snapshots(split_layer);
 
-  if (first_use) {
-      split_flap_layer_set_current_page(split_layer, 0, false);
+  // Stay on the same page if the new set has one, and show it - every page was hidden above.
+  if (split_layer->current_page >= num_pages) {
+    split_layer->current_page = 0;
+  }
+  if (num_pages) {
+    layer_set_hidden(pages[split_layer->current_page].upperLayer, false);
+    layer_set_hidden(pages[split_layer->current_page].lowerLayer, false);
+  }
+  layer_mark_dirty(split_layer->layer);
+}
+
+void split_flap_layer_set_data_source(SplitFlapLayer* split_layer, SplitFlapLayerDataSource data_source, void* context) {
+  split_flap_layer_stop_flip(split_layer);
+  split_flap_layer_release_page_pool(split_layer);
+  split_layer->pages = NULL;
+  split_layer->data_source = data_source;
+  split_layer->data_source_context = context;
+
+  layer_remove_child_layers(split_layer->layer);
+  for (int i = 0; i < SPLIT_FLAP_PAGE_POOL_SIZE; ++i) {
+    split_flap_layer_init_page(split_layer, &split_layer->page_pool[i]);
+    layer_set_hidden(split_layer->page_pool[i].upperLayer, true);
+    layer_set_hidden(split_layer->page_pool[i].lowerLayer, true);
+    layer_add_child(split_layer->layer, split_layer->page_pool[i].upperLayer);
+    layer_add_child(split_layer->layer, split_layer->page_pool[i].lowerLayer);
+  }
+  // Adding this as a child again will push it to the top of the z order
+  layer_add_child(split_layer->layer, split_layer->mask_layer);
+  split_flap_layer_build_geometry(split_layer, grect_crop(layer_get_bounds(split_layer->layer), FLAP_INSET));
+  split_flap_layer_alloc_snapshots(split_layer);
+
+  split_flap_layer_reload_data(split_layer);
+}
+
+void split_flap_layer_set_text_pages(SplitFlapLayer* split_layer, const char* const* texts, uint32_t num_texts, GFont font, GTextAlignment alignment) {
+  split_layer->texts = texts;
+  split_layer->num_texts = num_texts;
+  split_layer->text_font = font;
+  split_layer->text_alignment = alignment;
+  // Set directly, so the snapshot buffers are made for the new pages rather than the old ones.
+  split_layer->snapshot_mode = true;
+  split_flap_layer_set_data_source(split_layer, (SplitFlapLayerDataSource){
+    .get_num_pages = split_flap_text_get_num_pages,
+    .configure_page = split_flap_text_configure_page
+  }, NULL);
+}
+
+void split_flap_layer_reload_data(SplitFlapLayer* split_layer) {
+  if (!split_layer->data_source.configure_page) return;
+  split_flap_layer_stop_flip(split_layer);
+  // Every page might be different now.
+  for (int i = 0; i < SPLIT_FLAP_PAGE_POOL_SIZE; ++i) {
+    split_layer->page_pool_idx[i] = SPLIT_FLAP_PAGE_UNBOUND;
+    layer_set_hidden(split_layer->page_pool[i].upperLayer, true);
+    layer_set_hidden(split_layer->page_pool[i].lowerLayer, true);
+  }
+  split_layer->num_pages = split_layer->data_source.get_num_pages(split_layer, split_layer->data_source_context);
+  if (split_layer->current_page >= split_layer->num_pages) {
+    split_layer->current_page = 0;
+  }
+  if (split_layer->num_pages) {
+    SplitFlapLayerPage* page = split_flap_layer_get_page(split_layer, split_layer->current_page);
+    layer_set_hidden(page->upperLayer, false);
+    layer_set_hidden(page->lowerLayer, false);
   }
+  layer_mark_dirty(split_layer->layer);
+}
+
+void split_flap_layer_set_governor(SplitFlapLayer* split_layer, bool enabled, SplitFlapGovernor governor) {
+  split_layer->governor_enabled = enabled;
+  split_layer->governor = governor;
+  split_layer->governor_stride = 1;
+  split_layer->governor_min_stride = 1;
+  split_layer->governor_frame_ms = 0;
+}
+
+void split_flap_layer_set_easing(SplitFlapLayer* split_layer, SplitFlapEasing easing) {
+  split_layer->easing = easing;
 }
 
 void split_flap_layer_set_callbacks(SplitFlapLayer* split_layer, SplitFlapLayerCallbacks callbacks) {
   split_layer->callbacks = callbacks;
 }
 
+#ifdef SPLIT_FLAP_PROFILE
+void split_flap_layer_set_profile_handler(SplitFlapLayer* split_layer, SplitFlapLayerProfileHandler handler, void* context) {
+  split_layer->profile_handler = handler;
+  split_layer->profile_context = context;
+}
+#endif
+
+#ifdef SPLIT_FLAP_STATS
+const SplitFlapLayerStats* split_flap_layer_get_stats(SplitFlapLayer* split_layer) {
+  return &split_layer->stats;
+}
+
+void split_flap_layer_reset_stats(SplitFlapLayer* split_layer) {
+  memset(&split_layer->stats, 0, sizeof(SplitFlapLayerStats));
+}
+
+void split_flap_layer_log_stats(SplitFlapLayer* split_layer) {
+  SplitFlapLayerStats* stats = &split_layer->stats;
+  APP_LOG(APP_LOG_LEVEL_INFO, "split flap %p: %lu flips (%lu interrupted), %lu flip frames (%u last flip), %lu dropped, %lu mask redraws",
+          split_layer, stats->flips, stats->interrupted_flips, stats->flip_frames, stats->last_flip_frames, stats->dropped_frames, stats->mask_redraws);
+  APP_LOG(APP_LOG_LEVEL_INFO, "split flap %p: frames avg %lu ms, worst %u ms",
+          split_layer, stats->frames ? stats->total_frame_ms / stats->frames : 0, stats->worst_frame_ms);
+}
+
+void split_flap_layer_set_stats_log_interval(SplitFlapLayer* split_layer, uint16_t flips) {
+  split_layer->stats_log_interval = flips;
+}
+#endif
+
+void split_flap_layer_set_snapshot_mode(SplitFlapLayer* split_layer, bool enabled) {
+  split_layer->snapshot_mode = enabled;
+  if (enabled) {
+    split_flap_layer_alloc_snapshots(split_layer);
+  } else {
+    uint32_t num_pages;
+    SplitFlapLayerPage* pages = split_flap_layer_get_pages(split_layer, &num_pages);
+    for (uint i = 0; i < num_pages; ++i) {
+      split_flap_page_discard_snapshot(&pages[i]);
+    }
+  }
+  layer_mark_dirty(split_layer->layer);
+}
+
+void split_flap_layer_invalidate_page(SplitFlapLayer* split_layer, uint32_t page_idx) {
+  // A data source page that isn't bound has nothing cached - it's configured and drawn afresh when it's next needed.
+  SplitFlapLayerPage* page = split_flap_layer_find_page(split_layer, page_idx);
+  if (!page) return;
+  page->snapshotValid = false;
+  if (page_idx == split_layer->current_page) {
+    // It'll be snapshotted again next time it's drawn.
+    layer_mark_dirty(split_layer->layer);
+  }
+}
+
+void split_flap_layer_set_incremental_redraw(SplitFlapLayer* split_layer, bool enabled) {
+  split_layer->incremental_redraw = enabled;
+  split_layer->last_flip_valid = false;
+}
+
+void split_flap_layer_set_frame(SplitFlapLayer* split_layer, GRect frame) {
+  layer_set_frame(split_layer->layer, frame);
+  layer_set_bounds(split_layer->layer, GRect(0, 0, frame.size.w, frame.size.h));
+  layer_set_frame(split_layer->mask_layer, GRect(0, 0, frame.size.w, frame.size.h));
+  layer_set_bounds(split_layer->mask_layer, GRect(0, 0, frame.size.w, frame.size.h));
+  uint32_t num_pages;
+  SplitFlapLayerPage* pages = split_flap_layer_get_pages(split_layer, &num_pages);
+  for (uint i = 0; i < num_pages; ++i) {
+    split_flap_page_layer_setup(split_layer, &pages[i]);
+  }
+  split_flap_layer_build_geometry(split_layer, grect_crop(layer_get_bounds(split_layer->layer), FLAP_INSET));
+  // Snapshots of the old size are thrown away and made again at the new one.
+  split_flap_layer_alloc_snapshots(split_layer);
+  // The corners have moved, and the last frame's no use to an incremental redraw.
+  split_layer->corner_mask_ready = false;
+  split_layer->last_flip_valid = false;
+  layer_mark_dirty(split_layer->layer);
+}
+
+void split_flap_layer_set_screen_offset(SplitFlapLayer* split_layer, GPoint offset) {
+  split_layer->screen_offset = offset;
+}
+
 void split_flap_layer_deinit_page(SplitFlapLayerPage* page) {
   layer_destroy(page->upperLayer);
   layer_destroy(page->lowerLayer);
+  split_flap_page_discard_snapshot(page);
 }
 
-void split_flap_layer_destroy(SplitFlapLayer* split_layer) {
+void split_flap_layer_deinit(SplitFlapLayer* split_layer) {
+  if (split_layer->anim) {
+    animation_unschedule(split_layer->anim);
+  }
+  split_flap_layer_release_page_pool(split_layer);
   layer_destroy(split_layer->layer);
   layer_destroy(split_layer->mask_layer);
   if (split_layer->anim) {
-    free(split_layer->anim_implementation);
     animation_destroy(split_layer->anim);
   }
-  if (split_layer->mask_bmp) {
-    gbitmap_destroy(split_layer->mask_bmp);
-  }
+}
+
+void split_flap_layer_destroy(SplitFlapLayer* split_layer) {
+  split_flap_layer_deinit(split_layer);
   free(split_layer);
 }
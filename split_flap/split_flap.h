@@ -1,3 +1,4 @@
+#pragma once
 #include <pebble.h>
 
 typedef struct SplitFlapLayer SplitFlapLayer;
@@ -8,30 +9,153 @@ typedef struct SplitFlapLayerCallbacks {
   SplitFlapLayerPageChangedCallback page_changed;
 } SplitFlapLayerCallbacks;
 
+typedef enum {
+  SplitFlapEasingEaseInOut = 0,
+  SplitFlapEasingLinear,
+  SplitFlapEasingGravity // Falls, hits the bottom, bounces.
+} SplitFlapEasing;
+
+// Limits on how hard a flip can work (see split_flap_layer_set_governor).
+typedef struct SplitFlapGovernor {
+  uint16_t frame_budget_ms; // Draw fewer frames when they take longer than this (0 to ignore frame cost).
+  uint8_t low_battery_percent; // Draw fewer frames when the battery is at or below this and not charging (0 to ignore the battery).
+} SplitFlapGovernor;
+
 typedef struct SplitFlapLayerPage {
   Layer* upperLayer;
   Layer* lowerLayer;
+  // Cached renders of the two halves (snapshot mode only, managed by the control).
+  GBitmap* upperSnapshot;
+  GBitmap* lowerSnapshot;
+  bool snapshotValid;
 } SplitFlapLayerPage;
 
-// Create a new split flap layer with no pages.
+// Tells the layer how many pages there are.
+typedef uint32_t (*SplitFlapLayerGetNumPagesCallback)(struct SplitFlapLayer* split_layer, void* context);
+// Fill a (possibly recycled) page with the contents of page page_idx.
+typedef void (*SplitFlapLayerConfigurePageCallback)(struct SplitFlapLayer* split_layer, SplitFlapLayerPage* page, uint32_t page_idx, void* context);
+
+typedef struct SplitFlapLayerDataSource {
+  SplitFlapLayerGetNumPagesCallback get_num_pages;
+  SplitFlapLayerConfigurePageCallback configure_page;
+} SplitFlapLayerDataSource;
+
+#ifdef SPLIT_FLAP_PROFILE
+// What it cost to draw one frame of the control. Only the control's own drawing is counted, not your page update_procs (though they are included in the wall time).
+typedef struct SplitFlapLayerProfile {
+  uint32_t frame; // Frames drawn since the layer was created.
+  bool animating; // Whether a flip was in progress.
+  uint32_t anim_progress; // The (eased) flip progress the frame was drawn at.
+  uint16_t draw_calls; // graphics_* calls.
+  uint32_t pixels_filled; // Total area covered by those calls.
+  uint16_t frame_sets; // layer_set_frame calls on the page layers.
+  uint16_t bounds_sets; // layer_set_bounds calls on the page layers.
+  uint16_t wall_time_ms; // From the start of the background to the end of the mask, page update_procs and all.
+  uint32_t overdraw_pixels; // Pixels the control's own fills and blits covered more than once (page update_procs aren't counted).
+  uint8_t empty_layer_draws; // Visible page layers with nothing to show, whose update_procs run for nothing.
+  uint32_t checksum; // Of the control's finished pixels, for spotting when a change alters what's drawn.
+} SplitFlapLayerProfile;
+
+typedef void (*SplitFlapLayerProfileHandler)(struct SplitFlapLayer* split_layer, const SplitFlapLayerProfile* profile, void* context);
+#endif
+
+#ifdef SPLIT_FLAP_STATS
+// Running totals of how flips have played out, for keeping an eye on things in the field.
+typedef struct SplitFlapLayerStats {
+  uint32_t flips; // Flips that ran to the end.
+  uint32_t interrupted_flips; // Flips cut short by another page change.
+  uint32_t flip_frames; // Frames drawn during flips.
+  uint16_t last_flip_frames; // Frames drawn during the most recent flip.
+  uint32_t dropped_frames; // Frames the firmware never got round to, going by the gaps in the animation's progress.
+  uint32_t mask_redraws; // Frames that put the flap's rounded corners back: not a page at rest drawn from its snapshot, nor, in incremental mode, a flip frame whose changes miss the corners.
+  uint32_t frames; // Frames timed.
+  uint32_t total_frame_ms; // Divide by frames for the average.
+  uint16_t worst_frame_ms; // From the start of the background to the end of the mask, page update_procs and all.
+} SplitFlapLayerStats;
+#endif
+
+#include "split_flap_private.h"
+
+// Enough room for a SplitFlapLayer, for split_flap_layer_init - its actual size, on whatever you're building for.
+#define SPLIT_FLAP_LAYER_STORAGE_SIZE sizeof(struct SplitFlapLayer)
+
+typedef union SplitFlapLayerStorage {
+  uint8_t bytes[SPLIT_FLAP_LAYER_STORAGE_SIZE];
+  struct SplitFlapLayer align;
+} SplitFlapLayerStorage;
+
+// Create a new split flap layer with no pages (NULL if there isn't the memory).
 SplitFlapLayer* split_flap_layer_create(GRect frame);
+// Or build one inside a SplitFlapLayerStorage you own (a static one, say); its Layers and Animation still come from the firmware. Tear it down with split_flap_layer_deinit, not destroy.
+SplitFlapLayer* split_flap_layer_init(SplitFlapLayerStorage* storage, GRect frame);
+// The same, for a layer that's only ever flipped from outside (with split_flap_layer_begin_flip and friends, by a Transition or your own
+// Animation). It doesn't get an Animation of its own, so animated page changes made on it directly just jump to the page.
+SplitFlapLayer* split_flap_layer_create_driven(GRect frame);
+SplitFlapLayer* split_flap_layer_init_driven(SplitFlapLayerStorage* storage, GRect frame);
 // Get the underlying Layer*, to add into the main UI.
 Layer* split_flap_layer_get_layer(SplitFlapLayer* split_layer);
 // Set up the up/down page switch actions (entirely optional).
 void split_flap_set_click_config_onto_window(SplitFlapLayer* split_layer, Window* window);
 // Initialize a freshly allocated SplitFlapLayerPage.
 void split_flap_layer_init_page(SplitFlapLayer* split_layer, SplitFlapLayerPage* page);
-// Set the pages visible on the split flap layer.
+// Set the pages visible on the split flap layer. Any flip in progress ends, and the current page stays put unless the new set is too short for it, in which case it goes back to 0.
 void split_flap_layer_set_pages(SplitFlapLayer* split_layer, SplitFlapLayerPage* pages, uint32_t num_pages);
+// Get pages from a data source instead - the layer only keeps a few pages around and reconfigures them as you flip.
+void split_flap_layer_set_data_source(SplitFlapLayer* split_layer, SplitFlapLayerDataSource data_source, void* context);
+// Show a page per string instead, drawn centred across the split in the given font. The strings aren't copied, so keep them around.
+// This turns on snapshot mode, so a string is laid out when its page is first needed - once for a flip, or once per half when shown at rest -
+// and blitted from then on, until its page is recycled or the data reloaded.
+void split_flap_layer_set_text_pages(SplitFlapLayer* split_layer, const char* const* texts, uint32_t num_texts, GFont font, GTextAlignment alignment);
+// Ask the data source for the page count and page contents again.
+void split_flap_layer_reload_data(SplitFlapLayer* split_layer);
 // Get the current page index.
 int32_t split_flap_layer_get_current_page(SplitFlapLayer* split_layer);
-// Set the current page index.
+// Set the current page index (ignored if there is no such page).
 void split_flap_layer_set_current_page(SplitFlapLayer* split_layer, uint32_t page_idx, bool animated);
 // Change the current page index based on a delta (|delta| can be larger than num_pages).
 void split_flap_layer_set_current_page_by_delta(SplitFlapLayer* split_layer, int32_t delta, bool animated);
+// Queue up animated page changes made while a flip is running and play them back-to-back (quicker, and skipping pages when falling behind) instead of restarting the flip.
+// With batch_callbacks, page_changed is called once when the queue runs dry rather than for every page.
+void split_flap_layer_set_flip_queue(SplitFlapLayer* split_layer, bool enabled, bool batch_callbacks);
+// Flip through to page_idx, after anything already queued (needs the flip queue).
+void split_flap_layer_queue_flip_to(SplitFlapLayer* split_layer, uint32_t page_idx);
+// For driving flips from your own Animation: begin a flip to page_idx (false if there's nothing to flip, or no such page),
+// move the flap to the animation's time_normal, and end it. The flap only moves on screen when you mark the layer (or its parent) dirty.
+bool split_flap_layer_begin_flip(SplitFlapLayer* split_layer, uint32_t page_idx);
+void split_flap_layer_set_flip_progress(SplitFlapLayer* split_layer, uint32_t time_normal);
+void split_flap_layer_end_flip(SplitFlapLayer* split_layer);
+// Only redraw a flip when the flap has visibly moved, and cut down the number of steps it moves in when frames are over budget or the battery's low.
+void split_flap_layer_set_governor(SplitFlapLayer* split_layer, bool enabled, SplitFlapGovernor governor);
+// Choose how the flap moves (ease in-out by default).
+void split_flap_layer_set_easing(SplitFlapLayer* split_layer, SplitFlapEasing easing);
 // Specify the callbacks (as defined in struct SplitFlapLayerCallbacks).
 void split_flap_layer_set_callbacks(SplitFlapLayer* split_layer, SplitFlapLayerCallbacks callbacks);
+// Cache each page's halves once and draw from those, flipping or at rest, instead of re-running the page update_procs every frame.
+void split_flap_layer_set_snapshot_mode(SplitFlapLayer* split_layer, bool enabled);
+// Tell snapshot mode that a page's content has changed. Data source pages that aren't being kept around have nothing to forget, so this leaves them be.
+void split_flap_layer_invalidate_page(SplitFlapLayer* split_layer, uint32_t page_idx);
+// Only repaint the rows that changed between frames of a flip (needs snapshot mode, and a window background of GColorClear so the framebuffer keeps the rest).
+void split_flap_layer_set_incremental_redraw(SplitFlapLayer* split_layer, bool enabled);
+// Move or resize the layer. Use this rather than layer_set_frame on its Layer: it's what lays the pages out again and makes snapshot
+// buffers of the new size, which drawing never does.
+void split_flap_layer_set_frame(SplitFlapLayer* split_layer, GRect frame);
+// If the layer isn't a direct child of a full-screen layer, tell it where that parent sits on screen (the corner mask and snapshots are grabbed from the framebuffer).
+void split_flap_layer_set_screen_offset(SplitFlapLayer* split_layer, GPoint offset);
+#ifdef SPLIT_FLAP_PROFILE
+// Get called with the drawing cost of every frame (only available when built with SPLIT_FLAP_PROFILE defined).
+void split_flap_layer_set_profile_handler(SplitFlapLayer* split_layer, SplitFlapLayerProfileHandler handler, void* context);
+#endif
+#ifdef SPLIT_FLAP_STATS
+// Frame and flip statistics (only available when built with SPLIT_FLAP_STATS defined).
+const SplitFlapLayerStats* split_flap_layer_get_stats(SplitFlapLayer* split_layer);
+void split_flap_layer_reset_stats(SplitFlapLayer* split_layer);
+// APP_LOG the stats now, or automatically every so many flips (0 to stop).
+void split_flap_layer_log_stats(SplitFlapLayer* split_layer);
+void split_flap_layer_set_stats_log_interval(SplitFlapLayer* split_layer, uint16_t flips);
+#endif
 // Free resources associated with a SplitFlapLayerPage (does not free the page itself).
 void split_flap_layer_deinit_page(SplitFlapLayerPage* page);
 // Destroys a split flap layer.
 void split_flap_layer_destroy(SplitFlapLayer* split_layer);
+// Releases everything a split flap layer set up with split_flap_layer_init is holding onto (but not the storage itself).
+void split_flap_layer_deinit(SplitFlapLayer* split_layer);
@@ -0,0 +1,435 @@
+#include <pebble.h>
+#include "split_flap_bank.h"
+
+static const int BANK_FLIP_DURATION = 200; // msec, per cell
+
+// Snapshots of the two pages a cell is flipping between - only their snapshots are used. There's one of these for each cell flipping
+// at once, kept for later flips when it's done with.
+typedef struct SplitFlapBankFlip {
+  SplitFlapLayerPage pages[2]; // The disappearing page, then the appearing one.
+  struct SplitFlapBankFlip* next; // In the bank's spares.
+} SplitFlapBankFlip;
+
+typedef struct SplitFlapBankCell {
+  uint32_t page; // Showing, or flipping away from.
+  uint32_t appearing_page;
+  uint32_t delay; // msec
+  int32_t flip_start; // msec, relative to the start of the current run of the animation
+  SplitFlapBankFlip* flip; // Only while it's flipping.
+  uint8_t anim_step; // How far through its flip, in the bank's geometry steps
+  bool forward;
+} SplitFlapBankCell;
+
+typedef struct SplitFlapBank {
+  Layer* layer;
+  SplitFlapBankCell* cells;
+  uint32_t num_cells;
+  int16_t cell_w;
+
+  SplitFlapBankDataSource data_source;
+  void* data_source_context;
+
+  // Text pages (a data source of our own)
+  const char* const* texts;
+  uint32_t num_texts;
+  GFont text_font;
+  GTextAlignment text_alignment;
+
+  // The cells are all the same size, so they share the flap geometry and the corners.
+  SplitFlapGeometryStep geometry_steps[FLAP_GEOMETRY_STEPS + 1];
+  GBitmap corner_mask;
+  uint32_t corner_mask_pixels[FLAP_CORNER_RADIUS * 2 * FLAP_CORNER_MASK_ROW_SIZE / 4]; // Words, so it's aligned like a real bitmap.
+  bool corner_mask_ready;
+  SplitFlapBankFlip* spare_flips;
+
+  // One animation for the lot, long enough for the most delayed cell to finish.
+  Animation* anim;
+  uint32_t anim_duration;
+  uint32_t anim_elapsed;
+} SplitFlapBank;
+
+static GRect split_flap_bank_cell_rect(SplitFlapBank* bank, uint32_t cell_idx) {
+  GRect bounds = layer_get_bounds(bank->layer);
+  return GRect(bounds.origin.x + cell_idx * bank->cell_w, bounds.origin.y, bank->cell_w, bounds.size.h);
+}
+
+static uint32_t split_flap_bank_get_num_pages(SplitFlapBank* bank, uint32_t cell_idx) {
+  if (!bank->data_source.get_num_pages) return 0;
+  return bank->data_source.get_num_pages(bank, cell_idx, bank->data_source_context);
+}
+
+static bool split_flap_bank_flip_direction(uint32_t num_pages, uint32_t page_idx, uint32_t new_page_idx) {
+  // Wrapping round the end goes the way it would on a real one, as SplitFlapLayer does.
+  return (!(new_page_idx == num_pages - 1 && page_idx == 0) && new_page_idx > page_idx) || (new_page_idx == 0 && page_idx == num_pages - 1);
+}
+
+// A spare flip, or a new one - with its snapshot buffers made here, not while drawing. NULL if there isn't the memory.
+static SplitFlapBankFlip* split_flap_bank_take_flip(SplitFlapBank* bank) {
+  SplitFlapBankFlip* flip = bank->spare_flips;
+  if (flip) {
+    bank->spare_flips = flip->next;
+  } else {
+    flip = malloc(sizeof(SplitFlapBankFlip));
+    if (!flip) return NULL;
+    memset(flip, 0, sizeof(SplitFlapBankFlip));
+  }
+  GRect flapBounds = grect_crop(split_flap_bank_cell_rect(bank, 0), FLAP_INSET);
+  for (int i = 0; i < 2; ++i) {
+    if (!split_flap_page_alloc_snapshot(&flip->pages[i], GSize(flapBounds.size.w, flapBounds.size.h / 2))) {
+      flip->next = bank->spare_flips;
+      bank->spare_flips = flip;
+      return NULL;
+    }
+    flip->pages[i].snapshotValid = false;
+  }
+  return flip;
+}
+
+static void split_flap_bank_end_cell_flip(SplitFlapBank* bank, SplitFlapBankCell* cell) {
+  cell->page = cell->appearing_page;
+  cell->flip->next = bank->spare_flips;
+  bank->spare_flips = cell->flip;
+  cell->flip = NULL;
+  layer_mark_dirty(bank->layer);
+}
+
+static void split_flap_bank_animation_update(Animation* animation, const uint32_t time_normal) {
+  SplitFlapBank* bank = (SplitFlapBank*)animation_get_context(animation);
+  // Rounded, so a cell that starts with the animation gets the same progress a SplitFlapLayer's own animation would.
+  bank->anim_elapsed = (time_normal * bank->anim_duration + ANIMATION_NORMALIZED_MAX / 2) / ANIMATION_NORMALIZED_MAX;
+  // Idle cells cost nothing here.
+  bool moved = false;
+  for (uint i = 0; i < bank->num_cells; ++i) {
+    SplitFlapBankCell* cell = &bank->cells[i];
+    if (!cell->flip) continue;
+    int32_t cell_elapsed = (int32_t)bank->anim_elapsed - cell->flip_start;
+    if (cell_elapsed < 0) continue;
+    if (cell_elapsed >= BANK_FLIP_DURATION) {
+      split_flap_bank_end_cell_flip(bank, cell);
+      continue;
+    }
+    uint32_t progress = split_flap_ease(SplitFlapEasingEaseInOut, (cell_elapsed * ANIMATION_NORMALIZED_MAX) / BANK_FLIP_DURATION);
+    uint8_t step = (progress + FLAP_GEOMETRY_STEP_SIZE / 2) / FLAP_GEOMETRY_STEP_SIZE;
+    if (step != cell->anim_step) {
+      cell->anim_step = step;
+      moved = true;
+    }
+  }
+  // The whole window gets redrawn anyway, so once is plenty - and not at all if no flap has moved.
+  if (moved) {
+    layer_mark_dirty(bank->layer);
+  }
+}
+
+static void split_flap_bank_start_flips(SplitFlapBank* bank);
+
+static void split_flap_bank_animation_stopped(Animation* animation, bool finished, void* context) {
+  SplitFlapBank* bank = (SplitFlapBank*)context;
+  bool any_flipping = false;
+  for (uint i = 0; i < bank->num_cells; ++i) {
+    SplitFlapBankCell* cell = &bank->cells[i];
+    if (!cell->flip) continue;
+    if (finished) {
+      // Started partway through - it gets another run to finish in.
+      cell->flip_start -= bank->anim_duration;
+      any_flipping = true;
+    } else {
+      // Cut short, so settle it.
+      split_flap_bank_end_cell_flip(bank, cell);
+    }
+  }
+  if (any_flipping) {
+    split_flap_bank_start_flips(bank);
+  }
+}
+
+static const AnimationImplementation split_flap_bank_animation_implementation = {
+  .setup = NULL,
+  .update = split_flap_bank_animation_update,
+  .teardown = NULL
+};
+
+static void split_flap_bank_start_flips(SplitFlapBank* bank) {
+  int32_t duration = 0;
+  for (uint i = 0; i < bank->num_cells; ++i) {
+    if (bank->cells[i].flip && bank->cells[i].flip_start + BANK_FLIP_DURATION > duration) {
+      duration = bank->cells[i].flip_start + BANK_FLIP_DURATION;
+    }
+  }
+  if (!duration) return;
+
+  bank->anim_duration = duration;
+  bank->anim_elapsed = 0;
+  animation_set_duration(bank->anim, bank->anim_duration);
+  animation_schedule(bank->anim);
+}
+
+static bool split_flap_bank_is_animating(SplitFlapBank* bank) {
+  return animation_is_scheduled(bank->anim);
+}
+
+static void split_flap_bank_set_cell_page_internal(SplitFlapBank* bank, uint32_t cell_idx, uint32_t page_idx, bool animated) {
+  SplitFlapBankCell* cell = &bank->cells[cell_idx];
+  uint32_t num_pages = split_flap_bank_get_num_pages(bank, cell_idx);
+  if (page_idx >= num_pages) return;
+  if (cell->flip) {
+    split_flap_bank_end_cell_flip(bank, cell);
+  }
+  if (page_idx == cell->page) return;
+  SplitFlapBankFlip* flip = animated ? split_flap_bank_take_flip(bank) : NULL;
+  if (!flip) {
+    // Not animated, or no memory to animate it with, so go straight there.
+    cell->page = page_idx;
+    layer_mark_dirty(bank->layer);
+    return;
+  }
+  cell->flip = flip;
+  cell->appearing_page = page_idx;
+  cell->forward = split_flap_bank_flip_direction(num_pages, cell->page, page_idx);
+  cell->anim_step = 0;
+  // If the animation's already running, join in from where it's got to.
+  cell->flip_start = cell->delay + (split_flap_bank_is_animating(bank) ? bank->anim_elapsed : 0);
+}
+
+// Where the bank's top-left corner is in the framebuffer (it's a direct child of a full-screen layer).
+static GPoint split_flap_bank_get_screen_origin(SplitFlapBank* bank) {
+  return layer_get_frame(bank->layer).origin;
+}
+
+static void split_flap_bank_draw_split(SplitFlapBank* bank, GContext* ctx, GRect cell_rect, GRect flapBounds) {
+  int split_y = flapBounds.origin.y + flapBounds.size.h / 2;
+  graphics_context_set_fill_color(ctx, FLAP_FOREGROUND_COLOR);
+  graphics_fill_rect(ctx, GRect(cell_rect.origin.x, split_y - FLAP_SPLIT_HEIGHT / 2, cell_rect.size.w, FLAP_SPLIT_HEIGHT), 0, GCornerNone);
+}
+
+// The corners of a flap before anything's drawn on it, grabbed off the first frame to mask every cell with.
+static void split_flap_bank_capture_corner_mask(SplitFlapBank* bank, GContext* ctx) {
+  GRect flapBounds = grect_crop(split_flap_bank_cell_rect(bank, 0), FLAP_INSET);
+  graphics_context_set_fill_color(ctx, FLAP_BACKGROUND_COLOR);
+  graphics_fill_rect(ctx, flapBounds, FLAP_CORNER_RADIUS, GCornersAll);
+  split_flap_bitmap_init(&bank->corner_mask, ctx, bank->corner_mask_pixels, GSize(FLAP_CORNER_RADIUS * 2, FLAP_CORNER_RADIUS * 2), false);
+  GPoint origin = split_flap_bank_get_screen_origin(bank);
+  for (int i = 0; i < 4; ++i) {
+    GRect corner = split_flap_corner_rect(flapBounds, i);
+    GRect tile = split_flap_corner_tile(i);
+    split_flap_bitmap_copy(&bank->corner_mask, tile.origin, (GBitmap*)ctx, GRect(origin.x + corner.origin.x, origin.y + corner.origin.y, corner.size.w, corner.size.h));
+  }
+  bank->corner_mask_ready = true;
+}
+
+// Draw a page straight into the framebuffer, just as it'd look on its cell, and snapshot it. Whatever's drawn afterwards covers it up.
+// The flap's square, so the snapshot's corners are white and leave the flap border alone when it's AND-ed in mid-flip.
+static void split_flap_bank_snapshot_page(SplitFlapBank* bank, GContext* ctx, uint32_t cell_idx, uint32_t page_idx, SplitFlapLayerPage* page) {
+  GRect cell_rect = split_flap_bank_cell_rect(bank, cell_idx);
+  GRect flapBounds = grect_crop(cell_rect, FLAP_INSET);
+  GSize half_size = GSize(flapBounds.size.w, flapBounds.size.h / 2);
+  graphics_context_set_fill_color(ctx, FLAP_BACKGROUND_COLOR);
+  graphics_fill_rect(ctx, flapBounds, 0, GCornerNone);
+  split_flap_bank_draw_split(bank, ctx, cell_rect, flapBounds);
+  bank->data_source.draw_page(bank, ctx, flapBounds, cell_idx, page_idx, bank->data_source_context);
+  split_flap_bitmap_init(page->upperSnapshot, ctx, page->upperSnapshot->addr, half_size, true);
+  split_flap_bitmap_init(page->lowerSnapshot, ctx, page->lowerSnapshot->addr, half_size, true);
+  GPoint origin = split_flap_bank_get_screen_origin(bank);
+  GRect upper = GRect(origin.x + flapBounds.origin.x, origin.y + flapBounds.origin.y, half_size.w, half_size.h);
+  split_flap_bitmap_copy(page->upperSnapshot, GPointZero, (GBitmap*)ctx, upper);
+  split_flap_bitmap_copy(page->lowerSnapshot, GPointZero, (GBitmap*)ctx, GRect(upper.origin.x, upper.origin.y + flapBounds.size.h / 2, half_size.w, half_size.h));
+  page->snapshotValid = true;
+}
+
+static void split_flap_bank_draw_flip(SplitFlapBank* bank, GContext* ctx, SplitFlapBankCell* cell, GRect flapBounds) {
+  SplitFlapFlipGeometry geometry;
+  split_flap_get_flip_geometry(bank->geometry_steps, cell->anim_step, cell->forward, flapBounds, &cell->flip->pages[0], &cell->flip->pages[1], &geometry);
+  GCornerMask corners = geometry.flap_up ? GCornersTop : GCornersBottom;
+  // You can't set a stroke width, so we have to draw then crop then draw again.
+  graphics_context_set_fill_color(ctx, FLAP_FOREGROUND_COLOR);
+  graphics_fill_rect(ctx, grect_crop(geometry.flap_rect, -FLAP_SPLIT_HEIGHT), geometry.flap_corner_rad, corners);
+  graphics_context_set_fill_color(ctx, FLAP_BACKGROUND_COLOR);
+  graphics_fill_rect(ctx, geometry.flap_rect, geometry.flap_corner_rad == 0 ? 0 : geometry.flap_corner_rad - 1, corners);
+  // AND-ing the snapshots in keeps the flap border visible.
+  graphics_context_set_compositing_mode(ctx, GCompOpAnd);
+  for (int i = 0; i < 4; ++i) {
+    SplitFlapPiece* piece = &geometry.pieces[i];
+    if (piece->frame.size.h <= 0) continue;
+    // A stack copy with narrower bounds works just like a sub-bitmap.
+    GBitmap view = *(piece->lower ? piece->page->lowerSnapshot : piece->page->upperSnapshot);
+    view.bounds = GRect(0, piece->src_y, view.bounds.size.w, piece->frame.size.h);
+    view.is_heap_allocated = false;
+    graphics_draw_bitmap_in_rect(ctx, &view, piece->frame);
+  }
+  graphics_context_set_compositing_mode(ctx, GCompOpAssign);
+}
+
+// An idle cell costs its flap, the divider, its page and the corners. A flipping one blits its pages' snapshots instead, taking them
+// on its first frame.
+static void split_flap_bank_draw_cell(SplitFlapBank* bank, GContext* ctx, uint32_t cell_idx) {
+  SplitFlapBankCell* cell = &bank->cells[cell_idx];
+  GRect cell_rect = split_flap_bank_cell_rect(bank, cell_idx);
+  GRect flapBounds = grect_crop(cell_rect, FLAP_INSET);
+  if (cell->flip) {
+    uint32_t page_indices[2] = {cell->page, cell->appearing_page};
+    for (int i = 0; i < 2; ++i) {
+      if (!cell->flip->pages[i].snapshotValid) {
+        split_flap_bank_snapshot_page(bank, ctx, cell_idx, page_indices[i], &cell->flip->pages[i]);
+      }
+    }
+  }
+
+  graphics_context_set_fill_color(ctx, FLAP_BACKGROUND_COLOR);
+  graphics_fill_rect(ctx, flapBounds, FLAP_CORNER_RADIUS, GCornersAll);
+  split_flap_bank_draw_split(bank, ctx, cell_rect, flapBounds);
+  if (cell->flip) {
+    split_flap_bank_draw_flip(bank, ctx, cell, flapBounds);
+  } else if (bank->data_source.draw_page && cell->page < split_flap_bank_get_num_pages(bank, cell_idx)) {
+    bank->data_source.draw_page(bank, ctx, flapBounds, cell_idx, cell->page, bank->data_source_context);
+  }
+
+  // Put the rounded corners back over whatever the page drew.
+  graphics_context_set_compositing_mode(ctx, GCompOpAnd);
+  for (int i = 0; i < 4; ++i) {
+    GBitmap tile = bank->corner_mask;
+    tile.bounds = split_flap_corner_tile(i);
+    graphics_draw_bitmap_in_rect(ctx, &tile, split_flap_corner_rect(flapBounds, i));
+  }
+  graphics_context_set_compositing_mode(ctx, GCompOpAssign);
+}
+
+static void split_flap_bank_update_proc(Layer* layer, GContext* ctx) {
+  SplitFlapBank* bank = *(SplitFlapBank**)layer_get_data(layer);
+  if (!bank->corner_mask_ready) {
+    split_flap_bank_capture_corner_mask(bank, ctx);
+  }
+  for (uint i = 0; i < bank->num_cells; ++i) {
+    split_flap_bank_draw_cell(bank, ctx, i);
+  }
+}
+
+static void split_flap_bank_text_draw_page(SplitFlapBank* bank, GContext* ctx, GRect box, uint32_t cell_idx, uint32_t page_idx, void* context) {
+  const char* text = bank->texts[page_idx];
+  // Centred on the split, so it gets cut in half like the real thing.
+  GSize size = graphics_text_layout_get_max_used_size(ctx, text, bank->text_font, box, GTextOverflowModeWordWrap, bank->text_alignment, NULL);
+  graphics_context_set_text_color(ctx, FLAP_FOREGROUND_COLOR);
+  graphics_draw_text(ctx, text, bank->text_font, GRect(box.origin.x, box.origin.y + (box.size.h - size.h) / 2, box.size.w, size.h), GTextOverflowModeWordWrap, bank->text_alignment, NULL);
+}
+
+static uint32_t split_flap_bank_text_get_num_pages(SplitFlapBank* bank, uint32_t cell_idx, void* context) {
+  return bank->num_texts;
+}
+
+SplitFlapBank* split_flap_bank_create(GRect frame, uint32_t num_cells) {
+  if (!num_cells) return NULL;
+  SplitFlapBank* bank = malloc(sizeof(SplitFlapBank));
+  if (!bank) return NULL;
+  memset(bank, 0, sizeof(SplitFlapBank));
+  bank->cells = malloc(sizeof(SplitFlapBankCell) * num_cells);
+  if (!bank->cells) {
+    free(bank);
+    return NULL;
+  }
+  memset(bank->cells, 0, sizeof(SplitFlapBankCell) * num_cells);
+  bank->layer = layer_create_with_data(frame, sizeof(SplitFlapBank*));
+  bank->anim = animation_create();
+  if (!bank->layer || !bank->anim) {
+    if (bank->layer) layer_destroy(bank->layer);
+    if (bank->anim) animation_destroy(bank->anim);
+    free(bank->cells);
+    free(bank);
+    return NULL;
+  }
+  *(SplitFlapBank**)layer_get_data(bank->layer) = bank;
+  layer_set_update_proc(bank->layer, split_flap_bank_update_proc);
+
+  // Cells sit side by side, sharing the width equally.
+  bank->num_cells = num_cells;
+  bank->cell_w = frame.size.w / num_cells;
+  split_flap_build_geometry(bank->geometry_steps, grect_crop(split_flap_bank_cell_rect(bank, 0), FLAP_INSET));
+
+  AnimationHandlers callbacks = {
+    .started = NULL,
+    .stopped = split_flap_bank_animation_stopped
+  };
+  animation_set_handlers(bank->anim, callbacks, bank);
+  animation_set_implementation(bank->anim, &split_flap_bank_animation_implementation);
+  return bank;
+}
+
+Layer* split_flap_bank_get_layer(SplitFlapBank* bank) {
+  return bank->layer;
+}
+
+void split_flap_bank_set_data_source(SplitFlapBank* bank, SplitFlapBankDataSource data_source, void* context) {
+  // Settle whatever's flipping - its pages may not be there any more.
+  if (split_flap_bank_is_animating(bank)) {
+    animation_unschedule(bank->anim);
+  }
+  bank->data_source = data_source;
+  bank->data_source_context = context;
+  for (uint i = 0; i < bank->num_cells; ++i) {
+    if (bank->cells[i].page >= split_flap_bank_get_num_pages(bank, i)) {
+      bank->cells[i].page = 0;
+    }
+  }
+  layer_mark_dirty(bank->layer);
+}
+
+void split_flap_bank_set_text_pages(SplitFlapBank* bank, const char* const* texts, uint32_t num_texts, GFont font, GTextAlignment alignment) {
+  bank->texts = texts;
+  bank->num_texts = num_texts;
+  bank->text_font = font;
+  bank->text_alignment = alignment;
+  split_flap_bank_set_data_source(bank, (SplitFlapBankDataSource){
+    .get_num_pages = split_flap_bank_text_get_num_pages,
+    .draw_page = split_flap_bank_text_draw_page
+  }, NULL);
+}
+
+uint32_t split_flap_bank_get_cell_page(SplitFlapBank* bank, uint32_t cell_idx) {
+  return bank->cells[cell_idx].page;
+}
+
+void split_flap_bank_set_stagger(SplitFlapBank* bank, uint32_t stagger_ms) {
+  for (uint i = 0; i < bank->num_cells; ++i) {
+    bank->cells[i].delay = i * stagger_ms;
+  }
+}
+
+void split_flap_bank_set_cell_delay(SplitFlapBank* bank, uint32_t cell_idx, uint32_t delay_ms) {
+  bank->cells[cell_idx].delay = delay_ms;
+}
+
+void split_flap_bank_set_cell_page(SplitFlapBank* bank, uint32_t cell_idx, uint32_t page_idx, bool animated) {
+  split_flap_bank_set_cell_page_internal(bank, cell_idx, page_idx, animated);
+  if (animated && !split_flap_bank_is_animating(bank)) {
+    split_flap_bank_start_flips(bank);
+  }
+}
+
+void split_flap_bank_set_pages(SplitFlapBank* bank, const uint32_t* page_indices, bool animated) {
+  // Settle whatever's still going, so everyone starts together.
+  if (split_flap_bank_is_animating(bank)) {
+    animation_unschedule(bank->anim);
+  }
+  for (uint i = 0; i < bank->num_cells; ++i) {
+    split_flap_bank_set_cell_page_internal(bank, i, page_indices[i], animated);
+  }
+  if (animated) {
+    split_flap_bank_start_flips(bank);
+  }
+}
+
+void split_flap_bank_destroy(SplitFlapBank* bank) {
+  // Settling the flips hands their snapshots back to the spares.
+  if (split_flap_bank_is_animating(bank)) {
+    animation_unschedule(bank->anim);
+  }
+  animation_destroy(bank->anim);
+  while (bank->spare_flips) {
+    SplitFlapBankFlip* flip = bank->spare_flips;
+    bank->spare_flips = flip->next;
+    split_flap_page_discard_snapshot(&flip->pages[0]);
+    split_flap_page_discard_snapshot(&flip->pages[1]);
+    free(flip);
+  }
+  free(bank->cells);
+  layer_destroy(bank->layer);
+  free(bank);
+}
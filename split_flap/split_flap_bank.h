@@ -0,0 +1,37 @@
+#pragma once
+#include <pebble.h>
+#include "split_flap.h"
+
+typedef struct SplitFlapBank SplitFlapBank;
+
+// Tells the bank how many pages a cell has.
+typedef uint32_t (*SplitFlapBankGetNumPagesCallback)(SplitFlapBank* bank, uint32_t cell_idx, void* context);
+// Draw page page_idx of a cell into box (its flap, in the bank layer's coordinates). It goes on a blank flap, and the bank rounds the
+// corners off afterwards, but nothing else clips it - keep inside box. Only ever called while the bank is being drawn.
+typedef void (*SplitFlapBankDrawPageCallback)(SplitFlapBank* bank, GContext* ctx, GRect box, uint32_t cell_idx, uint32_t page_idx, void* context);
+
+typedef struct SplitFlapBankDataSource {
+  SplitFlapBankGetNumPagesCallback get_num_pages;
+  SplitFlapBankDrawPageCallback draw_page;
+} SplitFlapBankDataSource;
+
+// Create a row of num_cells split flap cells, drawn by one layer and flipped by one animation. NULL if num_cells is 0 or there isn't the memory.
+SplitFlapBank* split_flap_bank_create(GRect frame, uint32_t num_cells);
+// Get the underlying Layer*, to add into the main UI.
+Layer* split_flap_bank_get_layer(SplitFlapBank* bank);
+// Get the cells' pages from a data source.
+void split_flap_bank_set_data_source(SplitFlapBank* bank, SplitFlapBankDataSource data_source, void* context);
+// Or give every cell a page per string, drawn centred across the split in the given font. The strings aren't copied, so keep them around.
+void split_flap_bank_set_text_pages(SplitFlapBank* bank, const char* const* texts, uint32_t num_texts, GFont font, GTextAlignment alignment);
+// Get the page a cell is showing (the one it's flipping from, mid-flip).
+uint32_t split_flap_bank_get_cell_page(SplitFlapBank* bank, uint32_t cell_idx);
+// Delay each cell's flip by stagger_ms more than the one before it (the classic cascade).
+void split_flap_bank_set_stagger(SplitFlapBank* bank, uint32_t stagger_ms);
+// Delay one cell's flips by delay_ms.
+void split_flap_bank_set_cell_delay(SplitFlapBank* bank, uint32_t cell_idx, uint32_t delay_ms);
+// Set the current page of one cell (ignored if it has no such page).
+void split_flap_bank_set_cell_page(SplitFlapBank* bank, uint32_t cell_idx, uint32_t page_idx, bool animated);
+// Set the current page of every cell at once (page_indices has one entry per cell).
+void split_flap_bank_set_pages(SplitFlapBank* bank, const uint32_t* page_indices, bool animated);
+// Destroys the bank.
+void split_flap_bank_destroy(SplitFlapBank* bank);
@@ -0,0 +1,136 @@
+#pragma once
+// What a SplitFlapLayer is made of, and the drawing it shares with SplitFlapBank. split_flap.h includes this so that
+// SPLIT_FLAP_LAYER_STORAGE_SIZE can be the real size on every target, padding and all - none of it is for using directly, and it
+// changes whenever the control does.
+
+#define FLAP_INSET 4 // The padding around the flap area itself
+#define FLAP_SPLIT_HEIGHT 4 // The height of the middle divider
+#define FLAP_BACKGROUND_COLOR GColorWhite // Colour of the flap background
+#define FLAP_FOREGROUND_COLOR GColorBlack // Colour of the frame, divider, flap border.
+#define FLAP_CORNER_RADIUS 8 // The roundness of the flap corners
+#define FLAP_CORNER_MASK_ROW_SIZE (((FLAP_CORNER_RADIUS * 2 + 31) / 32) * 4) // Rows are word-aligned.
+// Enough for the current page, the one flipping in, and the one we just left (so flipping back is free).
+#define SPLIT_FLAP_PAGE_POOL_SIZE 3
+// How finely the flip progress is quantized - the flap geometry is worked out ahead of time for each step.
+#define FLAP_GEOMETRY_STEPS 64
+#define FLAP_GEOMETRY_STEP_SIZE ((ANIMATION_NORMALIZED_MAX + 1) / FLAP_GEOMETRY_STEPS)
+#ifdef SPLIT_FLAP_PROFILE
+#define SPLIT_FLAP_PROFILE_MAX_RECTS 24 // Plenty for a frame's worth of drawing
+#endif
+
+// One visible slice of a page half during a flip.
+typedef struct SplitFlapPiece {
+  SplitFlapLayerPage* page;
+  bool lower; // Which half of the page it is.
+  GRect frame; // Where it ends up.
+  int16_t src_y; // The first row of the page half that shows.
+} SplitFlapPiece;
+
+// The parts of the flap geometry that need division, for one step of the flip.
+typedef struct SplitFlapGeometryStep {
+  int16_t flap_h; // How tall the flap is.
+  uint8_t flap_corner_rad;
+} SplitFlapGeometryStep;
+
+// Everything about where things are on a given frame of a flip.
+typedef struct SplitFlapFlipGeometry {
+  bool flap_up; // Is the falling/rising flap above or below the half-way split?
+  bool finished_half; // Are we more than half-way through the animation?
+  GRect flap_rect; // The flap itself, without its border.
+  int flap_corner_rad;
+  SplitFlapPiece pieces[4];
+} SplitFlapFlipGeometry;
+
+struct SplitFlapLayer {
+  // Internal layers
+  Layer* layer;
+  Layer* mask_layer;
+  // The four corners of the flap, as they looked before any pages were drawn on them.
+  GBitmap corner_mask;
+  uint32_t corner_mask_pixels[FLAP_CORNER_RADIUS * 2 * FLAP_CORNER_MASK_ROW_SIZE / 4]; // Words, so it's aligned like a real bitmap.
+  bool corner_mask_ready;
+
+  // Pages
+  SplitFlapLayerPage* pages;
+  uint32_t num_pages;
+  uint32_t current_page;
+
+  // Data source mode: a handful of recycled pages stand in for however many the data source has.
+  SplitFlapLayerDataSource data_source;
+  void* data_source_context;
+  SplitFlapLayerPage page_pool[SPLIT_FLAP_PAGE_POOL_SIZE];
+  uint32_t page_pool_idx[SPLIT_FLAP_PAGE_POOL_SIZE]; // Which page each one is showing.
+
+  // Text pages (a data source of our own)
+  const char* const* texts;
+  uint32_t num_texts;
+  GFont text_font;
+  GTextAlignment text_alignment;
+
+  SplitFlapLayerCallbacks callbacks;
+
+  // Animation state
+  Animation* anim;
+  bool anim_forward;
+  uint32_t anim_progress;
+  uint32_t anim_step; // anim_progress, quantized to FLAP_GEOMETRY_STEPS
+  SplitFlapEasing easing;
+  SplitFlapGeometryStep geometry_steps[FLAP_GEOMETRY_STEPS + 1];
+  int16_t geometry_flap_h; // The flap height geometry_steps were worked out for.
+  uint32_t anim_appearing_page;
+  uint32_t anim_disappearing_page;
+  bool external_flip; // A flip driven by someone else's Animation is in progress.
+
+  // Governor
+  bool governor_enabled;
+  SplitFlapGovernor governor;
+  uint8_t governor_stride; // Only every this many geometry steps get drawn.
+  uint8_t governor_min_stride; // Raised while the battery's low.
+  uint16_t governor_frame_ms; // The (smoothed) cost of a frame.
+  uint32_t governor_frame_start_ms;
+
+  // Flip queue
+  bool flip_queue_enabled;
+  bool flip_queue_batch_callbacks;
+  int32_t flip_queue_delta; // Pages still to go after the current flip.
+  uint32_t flip_batch_start_page;
+
+  // Snapshot mode
+  bool snapshot_mode;
+  GPoint screen_offset;
+
+  // Incremental redraw
+  bool incremental_redraw;
+  bool last_flip_valid;
+  SplitFlapFlipGeometry last_flip; // Where everything was on the last frame we drew.
+  int16_t damage_top; // The rows being repainted this frame, so the mask can leave corners outside them alone.
+  int16_t damage_bottom;
+
+#ifdef SPLIT_FLAP_PROFILE
+  SplitFlapLayerProfile profile;
+  SplitFlapLayerProfileHandler profile_handler;
+  void* profile_context;
+  uint32_t profile_start_ms;
+  GRect profile_rects[SPLIT_FLAP_PROFILE_MAX_RECTS]; // Everything covered this frame, for working out the overdraw.
+  uint8_t profile_num_rects;
+#endif
+#ifdef SPLIT_FLAP_STATS
+  SplitFlapLayerStats stats;
+  uint16_t stats_log_interval;
+  uint32_t stats_start_ms;
+  uint16_t stats_flip_frames; // Frames so far in this flip.
+  uint32_t stats_anim_duration;
+  uint32_t stats_last_time_normal;
+#endif
+};
+
+// Shared with SplitFlapBank, which draws its cells the same way (in split_flap.c).
+uint32_t split_flap_ease(SplitFlapEasing easing, uint32_t time_normalized);
+void split_flap_build_geometry(SplitFlapGeometryStep* steps, GRect flapBounds);
+void split_flap_get_flip_geometry(const SplitFlapGeometryStep* steps, uint32_t anim_step, bool forward, GRect flapBounds, SplitFlapLayerPage* oldPage, SplitFlapLayerPage* newPage, SplitFlapFlipGeometry* geometry);
+void split_flap_bitmap_copy(GBitmap* dest, GPoint dest_origin, const GBitmap* src, GRect src_rect);
+void split_flap_bitmap_init(GBitmap* bitmap, GContext* ctx, void* pixels, GSize size, bool heap_allocated);
+GRect split_flap_corner_rect(GRect flapBounds, int corner);
+GRect split_flap_corner_tile(int corner);
+bool split_flap_page_alloc_snapshot(SplitFlapLayerPage* page, GSize size);
+void split_flap_page_discard_snapshot(SplitFlapLayerPage* page);
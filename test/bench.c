@@ -0,0 +1,136 @@
+// Prints what every frame of some typical flips and dot sweeps costs, for comparing before and after a change.
+#include "stub.h"
+#include "split_flap.h"
+#include "dots.h"
+
+#define NUM_PAGES 4
+
+static SplitFlapLayerPage s_pages[NUM_PAGES];
+static struct StubFont s_font = {12, 18};
+static const char* s_texts[NUM_PAGES] = {"LHR", "CDG", "JFK", "SFO"};
+
+// A page that takes some drawing: a grid of small boxes.
+static void busy_page_update_proc(Layer* layer, GContext* ctx) {
+  graphics_context_set_fill_color(ctx, GColorBlack);
+  for (int y = 2; y < 40; y += 6) {
+    for (int x = 4; x < 130; x += 6) {
+      graphics_fill_rect(ctx, GRect(x, y, 4, 4), 0, GCornerNone);
+    }
+  }
+}
+
+static StubFrameStats s_totals;
+static uint32_t s_num_frames;
+
+static void print_header(const char* name) {
+  memset(&s_totals, 0, sizeof(s_totals));
+  s_num_frames = 0;
+  printf("\n%s\n%6s %6s %8s %8s %8s %6s %6s %6s %8s\n", name, "frame", "draws", "pixels", "overdraw", "clipped", "frames", "bounds", "layers", "us");
+}
+
+static void print_frame(void) {
+  const StubFrameStats* f = stub_last_frame();
+  printf("%6u %6u %8u %8u %8u %6u %6u %6u %8u\n", f->frame, f->draw_calls, f->pixels_filled, f->overdraw_pixels, f->clipped_pixels,
+         f->frame_sets, f->bounds_sets, f->layer_draws, f->wall_time_us);
+  s_num_frames++;
+  s_totals.draw_calls += f->draw_calls;
+  s_totals.pixels_filled += f->pixels_filled;
+  s_totals.overdraw_pixels += f->overdraw_pixels;
+  s_totals.clipped_pixels += f->clipped_pixels;
+  s_totals.frame_sets += f->frame_sets;
+  s_totals.bounds_sets += f->bounds_sets;
+  s_totals.layer_draws += f->layer_draws;
+  s_totals.wall_time_us += f->wall_time_us;
+}
+
+static void print_totals(void) {
+  printf("%6s %6u %8u %8u %8u %6u %6u %6u %8u  (%u frames)\n", "total", s_totals.draw_calls, s_totals.pixels_filled, s_totals.overdraw_pixels, s_totals.clipped_pixels,
+         s_totals.frame_sets, s_totals.bounds_sets, s_totals.layer_draws, s_totals.wall_time_us, s_num_frames);
+}
+
+// Run frame by frame until everything's settled, printing each one.
+static void run_and_print(void) {
+  for (int i = 0; i < 100; ++i) {
+    uint32_t frames = stub_frames_drawn();
+    stub_run(STUB_FRAME_MS);
+    if (stub_frames_drawn() != frames) {
+      print_frame();
+    } else if (stub_run_until_idle(0) == 0) {
+      break;
+    }
+  }
+}
+
+typedef enum {
+  BenchPages,
+  BenchSnapshots,
+  BenchIncremental,
+  BenchText
+} BenchMode;
+
+static void bench_flips(const char* name, BenchMode mode) {
+  stub_reset(mode == BenchIncremental ? GColorClear : GColorBlack);
+  SplitFlapLayer* split_layer = split_flap_layer_create(GRect(0, 0, 144, 100));
+  if (mode == BenchText) {
+    split_flap_layer_set_text_pages(split_layer, s_texts, NUM_PAGES, &s_font, GTextAlignmentCenter);
+  } else {
+    for (int i = 0; i < NUM_PAGES; ++i) {
+      split_flap_layer_init_page(split_layer, &s_pages[i]);
+      layer_set_update_proc(s_pages[i].upperLayer, busy_page_update_proc);
+      layer_set_update_proc(s_pages[i].lowerLayer, busy_page_update_proc);
+    }
+    split_flap_layer_set_pages(split_layer, s_pages, NUM_PAGES);
+    split_flap_layer_set_snapshot_mode(split_layer, mode != BenchPages);
+    split_flap_layer_set_incremental_redraw(split_layer, mode == BenchIncremental);
+  }
+  layer_add_child(stub_window_layer(), split_flap_layer_get_layer(split_layer));
+  stub_run_until_idle(1000);
+
+  // Twice round, so snapshots have been taken the second time.
+  print_header(name);
+  for (int i = 0; i < NUM_PAGES * 2; ++i) {
+    split_flap_layer_set_current_page_by_delta(split_layer, 1, true);
+    run_and_print();
+  }
+  split_flap_layer_set_current_page_by_delta(split_layer, -1, true);
+  run_and_print();
+  print_totals();
+
+  if (mode != BenchText) {
+    for (int i = 0; i < NUM_PAGES; ++i) {
+      split_flap_layer_deinit_page(&s_pages[i]);
+    }
+  }
+  split_flap_layer_destroy(split_layer);
+}
+
+static void bench_dots(const char* name, int32_t num_dots, uint8_t max_visible, bool incremental, bool animated) {
+  stub_reset(incremental ? GColorClear : GColorBlack);
+  DotsLayer* dots_layer = dots_layer_create(GRect(0, 150, 144, 10));
+  dots_layer_set_max_visible(dots_layer, max_visible);
+  dots_layer_set_incremental_redraw(dots_layer, incremental);
+  layer_add_child(stub_window_layer(), dots_layer_get_layer(dots_layer));
+  dots_layer_update(dots_layer, num_dots, 0);
+  stub_run_until_idle(1000);
+  dots_layer_set_animated(dots_layer, animated);
+
+  print_header(name);
+  for (int32_t i = 1; i < num_dots; ++i) {
+    dots_layer_update(dots_layer, num_dots, i);
+    run_and_print();
+  }
+  print_totals();
+  dots_layer_destroy(dots_layer);
+}
+
+int main(void) {
+  bench_flips("split flap: page update_procs", BenchPages);
+  bench_flips("split flap: snapshots", BenchSnapshots);
+  bench_flips("split flap: snapshots, incremental", BenchIncremental);
+  bench_flips("split flap: text pages", BenchText);
+  bench_dots("dots: 9", 9, 0, false, false);
+  bench_dots("dots: 9, incremental", 9, 0, true, false);
+  bench_dots("dots: 40, window of 7", 40, 7, false, false);
+  bench_dots("dots: 9, sliding, incremental", 9, 0, true, true);
+  return 0;
+}
@@ -0,0 +1,207 @@
+#pragma once
+// Just enough of the Pebble SDK 2 API for the controls to build and run on a desktop machine (see README.md).
+// Types and calls match the SDK; what they do is implemented in pebble_stub.c.
+#include <stdint.h>
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include <sys/types.h>
+
+// Geometry
+typedef struct GPoint {
+  int16_t x;
+  int16_t y;
+} GPoint;
+
+typedef struct GSize {
+  int16_t w;
+  int16_t h;
+} GSize;
+
+typedef struct GRect {
+  GPoint origin;
+  GSize size;
+} GRect;
+
+#define GPoint(x, y) ((GPoint){(x), (y)})
+#define GSize(w, h) ((GSize){(w), (h)})
+#define GRect(x, y, w, h) ((GRect){{(x), (y)}, {(w), (h)}})
+#define GPointZero GPoint(0, 0)
+#define GRectZero GRect(0, 0, 0, 0)
+
+GRect grect_crop(GRect rect, const int32_t crop_size_px);
+
+// Graphics
+typedef enum GColor {
+  GColorClear = ~0,
+  GColorBlack = 0,
+  GColorWhite = 1
+} GColor;
+
+typedef enum {
+  GCornerNone = 0,
+  GCornerTopLeft = 1 << 0,
+  GCornerTopRight = 1 << 1,
+  GCornerBottomLeft = 1 << 2,
+  GCornerBottomRight = 1 << 3,
+  GCornersAll = GCornerTopLeft | GCornerTopRight | GCornerBottomLeft | GCornerBottomRight,
+  GCornersTop = GCornerTopLeft | GCornerTopRight,
+  GCornersBottom = GCornerBottomLeft | GCornerBottomRight,
+  GCornersRight = GCornerTopRight | GCornerBottomRight,
+  GCornersLeft = GCornerTopLeft | GCornerBottomLeft
+} GCornerMask;
+
+typedef enum {
+  GCompOpAssign,
+  GCompOpAssignInverted,
+  GCompOpOr,
+  GCompOpAnd,
+  GCompOpClear,
+  GCompOpSet
+} GCompOp;
+
+// 1 bit per pixel, least significant bit first, rows padded to a multiple of 4 bytes.
+typedef struct GBitmap {
+  void* addr;
+  uint16_t row_size_bytes;
+  union {
+    uint16_t info_flags;
+    struct {
+      bool is_heap_allocated:1;
+      uint16_t reserved:11;
+      uint8_t version:4;
+    };
+  };
+  GRect bounds;
+} GBitmap;
+
+typedef struct GContext GContext;
+
+void graphics_context_set_fill_color(GContext* ctx, GColor color);
+void graphics_context_set_stroke_color(GContext* ctx, GColor color);
+void graphics_context_set_text_color(GContext* ctx, GColor color);
+void graphics_context_set_compositing_mode(GContext* ctx, GCompOp mode);
+void graphics_fill_rect(GContext* ctx, GRect rect, uint16_t corner_radius, GCornerMask corner_mask);
+void graphics_fill_circle(GContext* ctx, GPoint p, uint16_t radius);
+void graphics_draw_bitmap_in_rect(GContext* ctx, const GBitmap* bitmap, GRect rect);
+void gbitmap_destroy(GBitmap* bitmap);
+
+// Text
+typedef struct StubFont* GFont;
+
+typedef enum {
+  GTextOverflowModeWordWrap,
+  GTextOverflowModeTrailingEllipsis,
+  GTextOverflowModeFill
+} GTextOverflowMode;
+
+typedef enum {
+  GTextAlignmentLeft,
+  GTextAlignmentCenter,
+  GTextAlignmentRight
+} GTextAlignment;
+
+typedef void* GTextLayoutCacheRef;
+
+void graphics_draw_text(GContext* ctx, const char* text, GFont const font, const GRect box, const GTextOverflowMode overflow_mode, const GTextAlignment alignment, const GTextLayoutCacheRef layout);
+GSize graphics_text_layout_get_max_used_size(GContext* ctx, const char* text, GFont const font, const GRect box, const GTextOverflowMode overflow_mode, const GTextAlignment alignment, const GTextLayoutCacheRef layout);
+
+// Layers
+typedef struct Layer Layer;
+typedef void (*LayerUpdateProc)(struct Layer* layer, GContext* ctx);
+
+Layer* layer_create(GRect frame);
+Layer* layer_create_with_data(GRect frame, size_t data_size);
+void layer_destroy(Layer* layer);
+void* layer_get_data(const Layer* layer);
+void layer_mark_dirty(Layer* layer);
+void layer_set_update_proc(Layer* layer, LayerUpdateProc update_proc);
+void layer_set_frame(Layer* layer, GRect frame);
+GRect layer_get_frame(const Layer* layer);
+void layer_set_bounds(Layer* layer, GRect bounds);
+GRect layer_get_bounds(const Layer* layer);
+void layer_set_hidden(Layer* layer, bool hidden);
+bool layer_get_hidden(const Layer* layer);
+void layer_set_clips(Layer* layer, bool clips);
+void layer_add_child(Layer* parent, Layer* child);
+void layer_remove_from_parent(Layer* child);
+void layer_remove_child_layers(Layer* parent);
+
+// Windows and clicks
+typedef struct Window Window;
+typedef void* ClickRecognizerRef;
+typedef void (*ClickHandler)(ClickRecognizerRef recognizer, void* context);
+typedef void (*ClickConfigProvider)(void* context);
+
+typedef enum {
+  BUTTON_ID_BACK = 0,
+  BUTTON_ID_UP,
+  BUTTON_ID_SELECT,
+  BUTTON_ID_DOWN,
+  NUM_BUTTONS
+} ButtonId;
+
+void window_single_repeating_click_subscribe(ButtonId button_id, uint16_t repeat_interval_ms, ClickHandler handler);
+void window_set_click_config_provider_with_context(Window* window, ClickConfigProvider click_config_provider, void* context);
+
+// Animations
+typedef struct Animation Animation;
+
+#define ANIMATION_NORMALIZED_MIN 0
+#define ANIMATION_NORMALIZED_MAX 65535
+
+typedef void (*AnimationSetupImplementation)(struct Animation* animation);
+typedef void (*AnimationUpdateImplementation)(struct Animation* animation, const uint32_t time_normalized);
+typedef void (*AnimationTeardownImplementation)(struct Animation* animation);
+
+typedef struct AnimationImplementation {
+  AnimationSetupImplementation setup;
+  AnimationUpdateImplementation update;
+  AnimationTeardownImplementation teardown;
+} AnimationImplementation;
+
+typedef void (*AnimationStartedHandler)(struct Animation* animation, void* context);
+typedef void (*AnimationStoppedHandler)(struct Animation* animation, bool finished, void* context);
+
+typedef struct AnimationHandlers {
+  AnimationStartedHandler started;
+  AnimationStoppedHandler stopped;
+} AnimationHandlers;
+
+Animation* animation_create(void);
+void animation_destroy(Animation* animation);
+void animation_set_handlers(Animation* animation, AnimationHandlers callbacks, void* context);
+void* animation_get_context(Animation* animation);
+void animation_set_implementation(Animation* animation, const AnimationImplementation* implementation);
+void animation_set_duration(Animation* animation, uint32_t duration_ms);
+void animation_schedule(Animation* animation);
+void animation_unschedule(Animation* animation);
+bool animation_is_scheduled(Animation* animation);
+
+// Services
+typedef struct BatteryChargeState {
+  uint8_t charge_percent;
+  bool is_charging;
+  bool is_plugged;
+} BatteryChargeState;
+
+BatteryChargeState battery_state_service_peek(void);
+uint16_t time_ms(time_t* tloc, uint16_t* out_ms);
+
+// Heap
+// malloc goes through the stub, so the tests can count what's allocated while drawing and make it fail.
+void* stub_malloc(size_t size);
+#define malloc(size) stub_malloc(size)
+
+// Logging
+typedef enum {
+  APP_LOG_LEVEL_ERROR = 1,
+  APP_LOG_LEVEL_WARNING = 50,
+  APP_LOG_LEVEL_INFO = 100,
+  APP_LOG_LEVEL_DEBUG = 200
+} AppLogLevel;
+
+void app_log(uint8_t log_level, const char* src_filename, int src_line_number, const char* fmt, ...);
+#define APP_LOG(level, fmt, args...) app_log(level, __FILE__, __LINE__, fmt, ## args)
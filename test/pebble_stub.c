@@ -0,0 +1,683 @@
+#include <stdarg.h>
+#include <stdio.h>
+#include <sys/time.h>
+#include "stub.h"
+
+int stub_failures = 0;
+
+// Framebuffer
+static uint8_t s_pixels[STUB_FRAMEBUFFER_SIZE];
+static uint8_t s_write_counts[STUB_SCREEN_W * STUB_SCREEN_H]; // Per pixel, this frame.
+
+struct GContext {
+  GBitmap dest_bitmap; // First, so the context can be read as the framebuffer bitmap (the controls rely on it).
+  GPoint origin; // Where the current layer's bounds origin is on screen.
+  GRect clip; // On screen.
+  GColor fill_color;
+  GColor stroke_color;
+  GColor text_color;
+  GCompOp compositing_mode;
+};
+
+static GContext s_ctx;
+
+struct Layer {
+  GRect frame;
+  GRect bounds;
+  bool hidden;
+  bool clips;
+  LayerUpdateProc update_proc;
+  Layer* parent;
+  Layer* first_child;
+  Layer* next_sibling;
+  void* data;
+};
+
+struct Animation {
+  AnimationHandlers handlers;
+  void* context;
+  const AnimationImplementation* implementation;
+  uint32_t duration;
+  bool scheduled;
+  uint32_t start_ms;
+  bool destroyed; // Freed once the tick it was destroyed in is over.
+  Animation* next;
+};
+
+static Layer* s_window_layer;
+static GColor s_background;
+static bool s_dirty;
+static uint32_t s_now_ms;
+static uint32_t s_frame_interval = STUB_FRAME_MS;
+static BatteryChargeState s_battery;
+static StubFrameStats s_frame_stats; // Being counted.
+static StubFrameStats s_last_frame_stats;
+static uint32_t s_frames;
+static Animation* s_animations;
+static bool s_ticking;
+static bool s_drawing;
+static uint32_t s_animations_created;
+static uint32_t s_animations_alive;
+static uint32_t s_allocations;
+static uint32_t s_draw_allocations;
+static bool s_malloc_fails;
+
+// Geometry
+
+GRect grect_crop(GRect rect, const int32_t crop_size_px) {
+  return GRect(rect.origin.x + crop_size_px, rect.origin.y + crop_size_px, rect.size.w - crop_size_px * 2, rect.size.h - crop_size_px * 2);
+}
+
+static GRect stub_intersect(GRect a, GRect b) {
+  int x0 = a.origin.x > b.origin.x ? a.origin.x : b.origin.x;
+  int y0 = a.origin.y > b.origin.y ? a.origin.y : b.origin.y;
+  int x1 = a.origin.x + a.size.w < b.origin.x + b.size.w ? a.origin.x + a.size.w : b.origin.x + b.size.w;
+  int y1 = a.origin.y + a.size.h < b.origin.y + b.size.h ? a.origin.y + a.size.h : b.origin.y + b.size.h;
+  return GRect(x0, y0, x1 > x0 ? x1 - x0 : 0, y1 > y0 ? y1 - y0 : 0);
+}
+
+// Pixels
+
+static bool stub_bitmap_get(const GBitmap* bitmap, int x, int y) {
+  const uint8_t* row = (const uint8_t*)bitmap->addr + y * bitmap->row_size_bytes;
+  return (row[x / 8] >> (x % 8)) & 1;
+}
+
+static void stub_screen_set(int x, int y, bool white) {
+  if (white) {
+    s_pixels[y * STUB_ROW_SIZE + x / 8] |= 1 << (x % 8);
+  } else {
+    s_pixels[y * STUB_ROW_SIZE + x / 8] &= ~(1 << (x % 8));
+  }
+}
+
+// Every pixel a drawing call writes comes through here, in the current layer's coordinates.
+static void stub_write_pixel(GContext* ctx, int x, int y, bool white) {
+  x += ctx->origin.x;
+  y += ctx->origin.y;
+  if (x < ctx->clip.origin.x || y < ctx->clip.origin.y || x >= ctx->clip.origin.x + ctx->clip.size.w || y >= ctx->clip.origin.y + ctx->clip.size.h) {
+    s_frame_stats.clipped_pixels++;
+    return;
+  }
+  s_frame_stats.pixels_filled++;
+  if (s_write_counts[y * STUB_SCREEN_W + x]++) {
+    s_frame_stats.overdraw_pixels++;
+  }
+  stub_screen_set(x, y, white);
+}
+
+// Graphics
+
+void graphics_context_set_fill_color(GContext* ctx, GColor color) {
+  ctx->fill_color = color;
+}
+
+void graphics_context_set_stroke_color(GContext* ctx, GColor color) {
+  ctx->stroke_color = color;
+}
+
+void graphics_context_set_text_color(GContext* ctx, GColor color) {
+  ctx->text_color = color;
+}
+
+void graphics_context_set_compositing_mode(GContext* ctx, GCompOp mode) {
+  ctx->compositing_mode = mode;
+}
+
+// Whether a pixel in a corner square is inside the rounded corner, dx and dy counting in from the corner.
+static bool stub_in_corner(int dx, int dy, int radius) {
+  int cx = 2 * (radius - dx) - 1;
+  int cy = 2 * (radius - dy) - 1;
+  return cx * cx + cy * cy <= 4 * radius * radius;
+}
+
+void graphics_fill_rect(GContext* ctx, GRect rect, uint16_t corner_radius, GCornerMask corner_mask) {
+  s_frame_stats.draw_calls++;
+  if (ctx->fill_color == GColorClear) return;
+  int radius = corner_radius;
+  if (radius * 2 > rect.size.w) radius = rect.size.w / 2;
+  if (radius * 2 > rect.size.h) radius = rect.size.h / 2;
+  for (int y = 0; y < rect.size.h; ++y) {
+    for (int x = 0; x < rect.size.w; ++x) {
+      int dx = x < radius ? x : rect.size.w - 1 - x;
+      int dy = y < radius ? y : rect.size.h - 1 - y;
+      if (dx < radius && dy < radius) {
+        GCornerMask corner = y < radius ? (x < radius ? GCornerTopLeft : GCornerTopRight) : (x < radius ? GCornerBottomLeft : GCornerBottomRight);
+        if ((corner_mask & corner) && !stub_in_corner(dx, dy, radius)) continue;
+      }
+      stub_write_pixel(ctx, rect.origin.x + x, rect.origin.y + y, ctx->fill_color == GColorWhite);
+    }
+  }
+}
+
+void graphics_fill_circle(GContext* ctx, GPoint p, uint16_t radius) {
+  s_frame_stats.draw_calls++;
+  if (ctx->fill_color == GColorClear) return;
+  int r = radius;
+  for (int y = -r; y <= r; ++y) {
+    for (int x = -r; x <= r; ++x) {
+      if (x * x + y * y <= r * r + r) {
+        stub_write_pixel(ctx, p.x + x, p.y + y, ctx->fill_color == GColorWhite);
+      }
+    }
+  }
+}
+
+// Tiles the bitmap's bounds over rect, combining each pixel with the framebuffer using the compositing mode.
+void graphics_draw_bitmap_in_rect(GContext* ctx, const GBitmap* bitmap, GRect rect) {
+  s_frame_stats.draw_calls++;
+  GRect src = bitmap->bounds;
+  if (src.size.w <= 0 || src.size.h <= 0) return;
+  for (int y = 0; y < rect.size.h; ++y) {
+    for (int x = 0; x < rect.size.w; ++x) {
+      bool s = stub_bitmap_get(bitmap, src.origin.x + x % src.size.w, src.origin.y + y % src.size.h);
+      switch (ctx->compositing_mode) {
+        case GCompOpAssign: stub_write_pixel(ctx, rect.origin.x + x, rect.origin.y + y, s); break;
+        case GCompOpAssignInverted: stub_write_pixel(ctx, rect.origin.x + x, rect.origin.y + y, !s); break;
+        case GCompOpOr: if (s) stub_write_pixel(ctx, rect.origin.x + x, rect.origin.y + y, true); break;
+        case GCompOpAnd: if (!s) stub_write_pixel(ctx, rect.origin.x + x, rect.origin.y + y, false); break;
+        case GCompOpClear: if (s) stub_write_pixel(ctx, rect.origin.x + x, rect.origin.y + y, false); break;
+        case GCompOpSet: if (!s) stub_write_pixel(ctx, rect.origin.x + x, rect.origin.y + y, true); break;
+      }
+    }
+  }
+}
+
+void gbitmap_destroy(GBitmap* bitmap) {
+  if (bitmap->is_heap_allocated) {
+    free(bitmap->addr);
+  }
+  free(bitmap);
+}
+
+// Text: a single line of blocky glyphs, no wrapping.
+
+GSize graphics_text_layout_get_max_used_size(GContext* ctx, const char* text, GFont const font, const GRect box, const GTextOverflowMode overflow_mode, const GTextAlignment alignment, const GTextLayoutCacheRef layout) {
+  int w = strlen(text) * font->glyph_w;
+  return GSize(w < box.size.w ? w : box.size.w, font->glyph_h);
+}
+
+void graphics_draw_text(GContext* ctx, const char* text, GFont const font, const GRect box, const GTextOverflowMode overflow_mode, const GTextAlignment alignment, const GTextLayoutCacheRef layout) {
+  s_frame_stats.draw_calls++;
+  if (ctx->text_color == GColorClear) return;
+  GSize size = graphics_text_layout_get_max_used_size(ctx, text, font, box, overflow_mode, alignment, layout);
+  int x0 = box.origin.x;
+  if (alignment == GTextAlignmentCenter) x0 += (box.size.w - size.w) / 2;
+  if (alignment == GTextAlignmentRight) x0 += box.size.w - size.w;
+  for (int i = 0; text[i]; ++i) {
+    unsigned char c = text[i];
+    for (int gy = 0; gy < font->glyph_h - 1; ++gy) {
+      for (int gx = 0; gx < font->glyph_w - 1; ++gx) {
+        int x = x0 + i * font->glyph_w + gx;
+        if (x >= box.origin.x + box.size.w || gy >= box.size.h) continue;
+        if (((c >> ((gx + gy) % 7)) ^ gx ^ gy) & 1) {
+          stub_write_pixel(ctx, x, box.origin.y + gy, ctx->text_color == GColorWhite);
+        }
+      }
+    }
+  }
+}
+
+// Layers
+
+Layer* layer_create_with_data(GRect frame, size_t data_size) {
+  Layer* layer = calloc(1, sizeof(Layer) + data_size);
+  layer->frame = frame;
+  layer->bounds = GRect(0, 0, frame.size.w, frame.size.h);
+  layer->clips = true;
+  layer->data = data_size ? (void*)(layer + 1) : NULL;
+  return layer;
+}
+
+Layer* layer_create(GRect frame) {
+  return layer_create_with_data(frame, 0);
+}
+
+void layer_remove_from_parent(Layer* child) {
+  Layer* parent = child->parent;
+  if (!parent) return;
+  Layer** link = &parent->first_child;
+  while (*link != child) {
+    link = &(*link)->next_sibling;
+  }
+  *link = child->next_sibling;
+  child->parent = NULL;
+  child->next_sibling = NULL;
+}
+
+void layer_remove_child_layers(Layer* parent) {
+  while (parent->first_child) {
+    layer_remove_from_parent(parent->first_child);
+  }
+}
+
+void layer_add_child(Layer* parent, Layer* child) {
+  layer_remove_from_parent(child);
+  Layer** link = &parent->first_child;
+  while (*link) {
+    link = &(*link)->next_sibling;
+  }
+  *link = child;
+  child->parent = parent;
+  s_dirty = true;
+}
+
+void layer_destroy(Layer* layer) {
+  layer_remove_from_parent(layer);
+  layer_remove_child_layers(layer);
+  free(layer);
+}
+
+void* layer_get_data(const Layer* layer) {
+  return layer->data;
+}
+
+// Changing a layer's frame, bounds, visibility or children marks it dirty too.
+void layer_mark_dirty(Layer* layer) {
+  s_frame_stats.dirty_marks++;
+  s_dirty = true;
+}
+
+void layer_set_update_proc(Layer* layer, LayerUpdateProc update_proc) {
+  layer->update_proc = update_proc;
+}
+
+void layer_set_frame(Layer* layer, GRect frame) {
+  s_frame_stats.frame_sets++;
+  s_dirty = true;
+  // Bounds that matched the old frame follow it, as they do on the watch.
+  bool bounds_in_sync = layer->bounds.origin.x == 0 && layer->bounds.origin.y == 0 && layer->bounds.size.w == layer->frame.size.w && layer->bounds.size.h == layer->frame.size.h;
+  layer->frame = frame;
+  if (bounds_in_sync) {
+    layer->bounds = GRect(0, 0, frame.size.w, frame.size.h);
+  }
+}
+
+GRect layer_get_frame(const Layer* layer) {
+  return layer->frame;
+}
+
+void layer_set_bounds(Layer* layer, GRect bounds) {
+  s_frame_stats.bounds_sets++;
+  s_dirty = true;
+  layer->bounds = bounds;
+}
+
+GRect layer_get_bounds(const Layer* layer) {
+  return layer->bounds;
+}
+
+void layer_set_hidden(Layer* layer, bool hidden) {
+  s_dirty |= hidden != layer->hidden;
+  layer->hidden = hidden;
+}
+
+bool layer_get_hidden(const Layer* layer) {
+  return layer->hidden;
+}
+
+void layer_set_clips(Layer* layer, bool clips) {
+  layer->clips = clips;
+}
+
+// Parents before children, children in the order they were added. Each update_proc gets a fresh drawing state.
+static void stub_render_layer(Layer* layer, GPoint parent_origin, GRect parent_clip) {
+  if (layer->hidden) return;
+  GRect frame = GRect(parent_origin.x + layer->frame.origin.x, parent_origin.y + layer->frame.origin.y, layer->frame.size.w, layer->frame.size.h);
+  GRect clip = layer->clips ? stub_intersect(parent_clip, frame) : parent_clip;
+  GPoint origin = GPoint(frame.origin.x + layer->bounds.origin.x, frame.origin.y + layer->bounds.origin.y);
+  if (layer->update_proc) {
+    s_frame_stats.layer_draws++;
+    if (layer->frame.size.w <= 0 || layer->frame.size.h <= 0) {
+      s_frame_stats.empty_layer_draws++;
+    }
+    s_ctx.origin = origin;
+    s_ctx.clip = clip;
+    s_ctx.fill_color = GColorBlack;
+    s_ctx.stroke_color = GColorBlack;
+    s_ctx.text_color = GColorBlack;
+    s_ctx.compositing_mode = GCompOpAssign;
+    layer->update_proc(layer, &s_ctx);
+  }
+  for (Layer* child = layer->first_child; child; child = child->next_sibling) {
+    stub_render_layer(child, origin, clip);
+  }
+}
+
+// Windows and clicks
+
+void window_single_repeating_click_subscribe(ButtonId button_id, uint16_t repeat_interval_ms, ClickHandler handler) {
+}
+
+void window_set_click_config_provider_with_context(Window* window, ClickConfigProvider click_config_provider, void* context) {
+}
+
+// Animations
+
+Animation* animation_create(void) {
+  Animation* animation = calloc(1, sizeof(Animation));
+  animation->duration = 250;
+  animation->next = s_animations;
+  s_animations = animation;
+  s_animations_created++;
+  s_animations_alive++;
+  return animation;
+}
+
+static void stub_free_destroyed_animations(void) {
+  Animation** link = &s_animations;
+  while (*link) {
+    Animation* animation = *link;
+    if (animation->destroyed) {
+      *link = animation->next;
+      free(animation);
+    } else {
+      link = &animation->next;
+    }
+  }
+}
+
+void animation_destroy(Animation* animation) {
+  animation_unschedule(animation);
+  animation->destroyed = true;
+  s_animations_alive--;
+  if (!s_ticking) {
+    stub_free_destroyed_animations();
+  }
+}
+
+void animation_set_handlers(Animation* animation, AnimationHandlers callbacks, void* context) {
+  animation->handlers = callbacks;
+  animation->context = context;
+}
+
+void* animation_get_context(Animation* animation) {
+  return animation->context;
+}
+
+void animation_set_implementation(Animation* animation, const AnimationImplementation* implementation) {
+  animation->implementation = implementation;
+}
+
+void animation_set_duration(Animation* animation, uint32_t duration_ms) {
+  animation->duration = duration_ms;
+}
+
+bool animation_is_scheduled(Animation* animation) {
+  return animation->scheduled;
+}
+
+static void stub_animation_stop(Animation* animation, bool finished) {
+  animation->scheduled = false;
+  if (animation->implementation && animation->implementation->teardown) {
+    animation->implementation->teardown(animation);
+  }
+  if (animation->handlers.stopped) {
+    animation->handlers.stopped(animation, finished, animation->context);
+  }
+}
+
+void animation_unschedule(Animation* animation) {
+  if (animation->scheduled) {
+    stub_animation_stop(animation, false);
+  }
+}
+
+// Like the firmware, scheduling a running animation stops it (unfinished) and starts it again.
+void animation_schedule(Animation* animation) {
+  animation_unschedule(animation);
+  animation->scheduled = true;
+  animation->start_ms = s_now_ms;
+  if (animation->implementation && animation->implementation->setup) {
+    animation->implementation->setup(animation);
+  }
+  if (animation->handlers.started) {
+    animation->handlers.started(animation, animation->context);
+  }
+}
+
+// Linear timing - the controls do their own easing.
+static void stub_tick_animations(void) {
+  s_ticking = true;
+  for (Animation* animation = s_animations; animation; animation = animation->next) {
+    if (!animation->scheduled || animation->destroyed || animation->start_ms == s_now_ms) continue;
+    uint32_t elapsed = s_now_ms - animation->start_ms;
+    if (elapsed >= animation->duration) {
+      animation->implementation->update(animation, ANIMATION_NORMALIZED_MAX);
+      stub_animation_stop(animation, true);
+    } else {
+      animation->implementation->update(animation, (uint64_t)elapsed * ANIMATION_NORMALIZED_MAX / animation->duration);
+    }
+  }
+  s_ticking = false;
+  stub_free_destroyed_animations();
+}
+
+static bool stub_animations_running(void) {
+  for (Animation* animation = s_animations; animation; animation = animation->next) {
+    if (animation->scheduled && !animation->destroyed) return true;
+  }
+  return false;
+}
+
+// Services
+
+BatteryChargeState battery_state_service_peek(void) {
+  return s_battery;
+}
+
+uint16_t time_ms(time_t* tloc, uint16_t* out_ms) {
+  if (tloc) *tloc = s_now_ms / 1000;
+  if (out_ms) *out_ms = s_now_ms % 1000;
+  return s_now_ms % 1000;
+}
+
+void app_log(uint8_t log_level, const char* src_filename, int src_line_number, const char* fmt, ...) {
+  if (!getenv("STUB_LOG")) return;
+  va_list args;
+  va_start(args, fmt);
+  fprintf(stderr, "%s:%d: ", src_filename, src_line_number);
+  vfprintf(stderr, fmt, args);
+  fprintf(stderr, "\n");
+  va_end(args);
+}
+
+// Heap
+
+#undef malloc
+void* stub_malloc(size_t size) {
+  s_allocations++;
+  if (s_drawing) s_draw_allocations++;
+  return s_malloc_fails ? NULL : malloc(size);
+}
+
+// Driving it all
+
+void stub_reset(GColor background) {
+  if (s_window_layer) {
+    layer_destroy(s_window_layer);
+  }
+  s_window_layer = layer_create(GRect(0, 0, STUB_SCREEN_W, STUB_SCREEN_H));
+  s_background = background;
+  s_dirty = true;
+  s_now_ms = 0;
+  s_frame_interval = STUB_FRAME_MS;
+  s_battery = (BatteryChargeState){.charge_percent = 100};
+  s_frames = 0;
+  s_allocations = 0;
+  s_draw_allocations = 0;
+  s_malloc_fails = false;
+  memset(&s_frame_stats, 0, sizeof(s_frame_stats));
+  memset(&s_last_frame_stats, 0, sizeof(s_last_frame_stats));
+  memset(s_pixels, 0, sizeof(s_pixels));
+  memset(&s_ctx, 0, sizeof(s_ctx));
+  s_ctx.dest_bitmap.addr = s_pixels;
+  s_ctx.dest_bitmap.row_size_bytes = STUB_ROW_SIZE;
+  s_ctx.dest_bitmap.bounds = GRect(0, 0, STUB_SCREEN_W, STUB_SCREEN_H);
+}
+
+Layer* stub_window_layer(void) {
+  return s_window_layer;
+}
+
+// Like the firmware, anything marked dirty while drawing is covered by the frame being drawn.
+bool stub_render(void) {
+  if (!s_dirty) return false;
+  struct timeval start, end;
+  gettimeofday(&start, NULL);
+  memset(s_write_counts, 0, sizeof(s_write_counts));
+  if (s_background != GColorClear) {
+    memset(s_pixels, s_background == GColorWhite ? 0xff : 0x00, sizeof(s_pixels));
+  }
+  s_drawing = true;
+  stub_render_layer(s_window_layer, GPointZero, GRect(0, 0, STUB_SCREEN_W, STUB_SCREEN_H));
+  s_drawing = false;
+  gettimeofday(&end, NULL);
+  s_dirty = false;
+  s_frame_stats.frame = ++s_frames;
+  s_frame_stats.wall_time_us = (end.tv_sec - start.tv_sec) * 1000000 + (end.tv_usec - start.tv_usec);
+  s_last_frame_stats = s_frame_stats;
+  memset(&s_frame_stats, 0, sizeof(s_frame_stats));
+  return true;
+}
+
+bool stub_drawing(void) {
+  return s_drawing;
+}
+
+void stub_set_frame_interval(uint32_t ms) {
+  s_frame_interval = ms;
+}
+
+static void stub_frame(void) {
+  s_now_ms += s_frame_interval;
+  stub_tick_animations();
+  stub_render();
+}
+
+void stub_run(uint32_t ms) {
+  uint32_t end = s_now_ms + ms;
+  while (s_now_ms < end) {
+    stub_frame();
+  }
+}
+
+uint32_t stub_run_until_idle(uint32_t max_ms) {
+  uint32_t frames = s_frames;
+  uint32_t end = s_now_ms + max_ms;
+  stub_render();
+  while ((stub_animations_running() || s_dirty) && s_now_ms < end) {
+    stub_frame();
+  }
+  return s_frames - frames;
+}
+
+uint32_t stub_clock_ms(void) {
+  return s_now_ms;
+}
+
+void stub_clock_advance(uint32_t ms) {
+  s_now_ms += ms;
+}
+
+void stub_set_battery(BatteryChargeState state) {
+  s_battery = state;
+}
+
+const StubFrameStats* stub_last_frame(void) {
+  return &s_last_frame_stats;
+}
+
+uint32_t stub_frames_drawn(void) {
+  return s_frames;
+}
+
+uint32_t stub_animations_created(void) {
+  return s_animations_created;
+}
+
+uint32_t stub_animations_alive(void) {
+  return s_animations_alive;
+}
+
+uint32_t stub_allocations(void) {
+  return s_allocations;
+}
+
+uint32_t stub_draw_allocations(void) {
+  return s_draw_allocations;
+}
+
+void stub_set_malloc_fails(bool fails) {
+  s_malloc_fails = fails;
+}
+
+GBitmap* stub_framebuffer(void) {
+  return &s_ctx.dest_bitmap;
+}
+
+bool stub_get_pixel(int x, int y) {
+  return stub_bitmap_get(&s_ctx.dest_bitmap, x, y);
+}
+
+void stub_copy_framebuffer(uint8_t* pixels) {
+  memcpy(pixels, s_pixels, sizeof(s_pixels));
+}
+
+uint32_t stub_count_diff(const uint8_t* a, const uint8_t* b, GRect rect) {
+  uint32_t diff = 0;
+  for (int y = rect.origin.y; y < rect.origin.y + rect.size.h; ++y) {
+    for (int x = rect.origin.x; x < rect.origin.x + rect.size.w; ++x) {
+      int i = y * STUB_ROW_SIZE + x / 8;
+      diff += ((a[i] ^ b[i]) >> (x % 8)) & 1;
+    }
+  }
+  return diff;
+}
+
+// Raw PBM rows are packed most significant bit first, 1 for black.
+static uint8_t stub_pbm_byte(GRect rect, int y, int byte) {
+  uint8_t bits = 0;
+  for (int i = 0; i < 8; ++i) {
+    int x = rect.origin.x + byte * 8 + i;
+    if (x < rect.origin.x + rect.size.w && !stub_get_pixel(x, y)) {
+      bits |= 0x80 >> i;
+    }
+  }
+  return bits;
+}
+
+bool stub_write_pbm(const char* path, GRect rect) {
+  FILE* f = fopen(path, "wb");
+  if (!f) return false;
+  fprintf(f, "P4\n%d %d\n", rect.size.w, rect.size.h);
+  for (int y = rect.origin.y; y < rect.origin.y + rect.size.h; ++y) {
+    for (int byte = 0; byte < (rect.size.w + 7) / 8; ++byte) {
+      fputc(stub_pbm_byte(rect, y, byte), f);
+    }
+  }
+  return fclose(f) == 0;
+}
+
+int32_t stub_compare_pbm(const char* path, GRect rect) {
+  FILE* f = fopen(path, "rb");
+  if (!f) return -1;
+  int w, h;
+  if (fscanf(f, "P4 %d %d", &w, &h) != 2 || fgetc(f) != '\n' || w != rect.size.w || h != rect.size.h) {
+    fclose(f);
+    return -1;
+  }
+  int32_t diff = 0;
+  for (int y = rect.origin.y; y < rect.origin.y + rect.size.h; ++y) {
+    for (int byte = 0; byte < (rect.size.w + 7) / 8; ++byte) {
+      int c = fgetc(f);
+      if (c == EOF) {
+        fclose(f);
+        return -1;
+      }
+      diff += __builtin_popcount((c ^ stub_pbm_byte(rect, y, byte)) & 0xff);
+    }
+  }
+  fclose(f);
+  return diff;
+}
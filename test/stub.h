@@ -0,0 +1,80 @@
+#pragma once
+// Drives the pebble.h stand-in: a 144x168 1-bit framebuffer, a single window, and a fake clock that only moves when told to.
+#include <stdio.h>
+#include <pebble.h>
+
+#define STUB_SCREEN_W 144
+#define STUB_SCREEN_H 168
+#define STUB_ROW_SIZE 20 // Bytes per framebuffer row, like the real thing.
+#define STUB_FRAMEBUFFER_SIZE (STUB_ROW_SIZE * STUB_SCREEN_H)
+#define STUB_FRAME_MS 33 // How often animations tick, unless changed with stub_set_frame_interval.
+
+// Characters are drawn as glyph_w x glyph_h blocks with a pattern that depends on the character.
+struct StubFont {
+  uint8_t glyph_w;
+  uint8_t glyph_h;
+};
+
+// What went into one frame (everything since the previous frame was drawn, for the counts of calls).
+typedef struct StubFrameStats {
+  uint32_t frame; // Frames drawn since stub_reset.
+  uint32_t draw_calls; // graphics_* drawing calls.
+  uint32_t pixels_filled; // Pixels those calls wrote (inside the clip).
+  uint32_t overdraw_pixels; // Pixels written more than once.
+  uint32_t clipped_pixels; // Pixels those calls tried to write outside the clip.
+  uint32_t frame_sets; // layer_set_frame calls.
+  uint32_t bounds_sets; // layer_set_bounds calls.
+  uint32_t dirty_marks; // layer_mark_dirty calls.
+  uint32_t layer_draws; // update_procs run.
+  uint32_t empty_layer_draws; // update_procs run for a layer with an empty frame.
+  uint32_t wall_time_us; // Real time spent drawing the frame.
+} StubFrameStats;
+
+// Start again: an empty window with the given background colour, the clock at 0, the counters cleared.
+void stub_reset(GColor background);
+// The window's root layer (full screen).
+Layer* stub_window_layer(void);
+// Draw the window, if anything's been marked dirty (the firmware redraws the whole window, and so does this). Returns whether it drew.
+bool stub_render(void);
+// Advance the clock by ms, ticking animations and drawing a frame every frame interval.
+void stub_run(uint32_t ms);
+// Run until there's nothing scheduled or dirty (or max_ms has passed). Returns the number of frames drawn.
+uint32_t stub_run_until_idle(uint32_t max_ms);
+void stub_set_frame_interval(uint32_t ms);
+// Whether the window is being drawn right now (for checking what gets called from update_procs).
+bool stub_drawing(void);
+
+// The fake clock (time_ms reads it). Advancing it from an update_proc makes that frame look expensive.
+uint32_t stub_clock_ms(void);
+void stub_clock_advance(uint32_t ms);
+void stub_set_battery(BatteryChargeState state);
+
+// Frame stats
+const StubFrameStats* stub_last_frame(void);
+uint32_t stub_frames_drawn(void);
+uint32_t stub_animations_created(void);
+uint32_t stub_animations_alive(void);
+// mallocs made since stub_reset, and how many of those were made from update_procs.
+uint32_t stub_allocations(void);
+uint32_t stub_draw_allocations(void);
+// Make malloc return NULL (or stop doing so).
+void stub_set_malloc_fails(bool fails);
+
+// The framebuffer
+GBitmap* stub_framebuffer(void);
+bool stub_get_pixel(int x, int y);
+void stub_copy_framebuffer(uint8_t* pixels);
+// How many pixels in rect differ between two framebuffer copies.
+uint32_t stub_count_diff(const uint8_t* a, const uint8_t* b, GRect rect);
+// Write rect of the framebuffer as a raw PBM (black is 1), or count how many pixels differ from one. Returns -1 if it can't be read.
+bool stub_write_pbm(const char* path, GRect rect);
+int32_t stub_compare_pbm(const char* path, GRect rect);
+
+// For the tests
+extern int stub_failures;
+#define CHECK(cond) do { \
+    if (!(cond)) { \
+      ++stub_failures; \
+      fprintf(stderr, "%s:%d: %s: CHECK(%s) failed\n", __FILE__, __LINE__, __func__, #cond); \
+    } \
+  } while (0)
@@ -0,0 +1,127 @@
+#include "stub.h"
+#include "dots.h"
+
+#define DOTS_FRAME GRect(0, 150, 144, 10)
+
+static DotsLayer* create_dots(GColor background) {
+  stub_reset(background);
+  DotsLayer* dots_layer = dots_layer_create(DOTS_FRAME);
+  layer_add_child(stub_window_layer(), dots_layer_get_layer(dots_layer));
+  return dots_layer;
+}
+
+static uint32_t count_white(GRect rect) {
+  uint32_t white = 0;
+  for (int y = rect.origin.y; y < rect.origin.y + rect.size.h; ++y) {
+    for (int x = rect.origin.x; x < rect.origin.x + rect.size.w; ++x) {
+      white += stub_get_pixel(x, y);
+    }
+  }
+  return white;
+}
+
+static void test_active_dot_is_hollow(void) {
+  DotsLayer* dots_layer = create_dots(GColorBlack);
+  dots_layer_update(dots_layer, 5, 2);
+  stub_run_until_idle(1000);
+  // The middle dot's centre is punched out, the others are solid.
+  CHECK(!stub_get_pixel(72, 154));
+  CHECK(stub_get_pixel(72 - 14, 154));
+  CHECK(stub_get_pixel(72 + 14, 154));
+  CHECK(count_white(GRect(0, 140, 144, 28)) > 0);
+  dots_layer_destroy(dots_layer);
+}
+
+// What a layer that's only ever shown this looks like.
+static void render_fresh(int32_t num_dots, int32_t active_dot, uint8_t max_visible, uint8_t* pixels) {
+  DotsLayer* dots_layer = create_dots(GColorBlack);
+  dots_layer_set_max_visible(dots_layer, max_visible);
+  dots_layer_update(dots_layer, num_dots, active_dot);
+  stub_run_until_idle(1000);
+  stub_copy_framebuffer(pixels);
+  dots_layer_destroy(dots_layer);
+}
+
+static uint32_t fresh_diff(int32_t num_dots, int32_t active_dot, uint8_t max_visible) {
+  static uint8_t drawn[STUB_FRAMEBUFFER_SIZE];
+  static uint8_t expected[STUB_FRAMEBUFFER_SIZE];
+  stub_copy_framebuffer(drawn);
+  render_fresh(num_dots, active_dot, max_visible, expected);
+  return stub_count_diff(drawn, expected, GRect(0, 140, 144, 28));
+}
+
+// With nothing else clearing the framebuffer, fewer dots mustn't leave the old ones behind.
+static void test_incremental_dot_count_change(void) {
+  DotsLayer* dots_layer = create_dots(GColorClear);
+  dots_layer_set_incremental_redraw(dots_layer, true);
+  dots_layer_update(dots_layer, 9, 4);
+  stub_run_until_idle(1000);
+  dots_layer_update(dots_layer, 3, 1);
+  stub_run_until_idle(1000);
+  dots_layer_destroy(dots_layer);
+  CHECK(fresh_diff(3, 1, 0) == 0);
+}
+
+// Scrolling the window shrinks dots that used to be full size, so the old ones mustn't show through.
+static void test_incremental_window_scroll(void) {
+  DotsLayer* dots_layer = create_dots(GColorClear);
+  dots_layer_set_incremental_redraw(dots_layer, true);
+  dots_layer_set_max_visible(dots_layer, 7);
+  dots_layer_update(dots_layer, 40, 0);
+  stub_run_until_idle(1000);
+  for (int32_t i = 1; i < 6; ++i) {
+    dots_layer_update(dots_layer, 40, i);
+    stub_run_until_idle(1000);
+  }
+  dots_layer_destroy(dots_layer);
+  CHECK(fresh_diff(40, 5, 7) == 0);
+
+  // Jumping a long way, and sliding.
+  dots_layer = create_dots(GColorClear);
+  dots_layer_set_incremental_redraw(dots_layer, true);
+  dots_layer_set_max_visible(dots_layer, 7);
+  dots_layer_update(dots_layer, 40, 39);
+  stub_run_until_idle(1000);
+  dots_layer_set_animated(dots_layer, true);
+  dots_layer_update(dots_layer, 40, 20);
+  stub_run_until_idle(1000);
+  dots_layer_update(dots_layer, 40, 19);
+  stub_run_until_idle(1000);
+  dots_layer_destroy(dots_layer);
+  CHECK(fresh_diff(40, 19, 7) == 0);
+}
+
+// The Animation's made along with the layer, so sliding doesn't allocate - unless the layer's only slid from outside.
+static void test_animation_made_at_init(void) {
+  uint32_t created = stub_animations_created();
+  DotsLayer* dots_layer = create_dots(GColorBlack);
+  CHECK(stub_animations_created() - created == 1);
+  dots_layer_set_animated(dots_layer, true);
+  dots_layer_update(dots_layer, 5, 3);
+  stub_run_until_idle(1000);
+  dots_layer_update(dots_layer, 5, 4);
+  stub_run_until_idle(1000);
+  CHECK(stub_animations_created() - created == 1);
+  dots_layer_destroy(dots_layer);
+
+  // A driven layer asked to slide by itself just moves.
+  created = stub_animations_created();
+  dots_layer = dots_layer_create_driven(DOTS_FRAME);
+  layer_add_child(stub_window_layer(), dots_layer_get_layer(dots_layer));
+  dots_layer_set_animated(dots_layer, true);
+  dots_layer_update(dots_layer, 5, 1);
+  dots_layer_update(dots_layer, 5, 2);
+  CHECK(stub_run_until_idle(1000) == 1);
+  CHECK(stub_animations_created() == created);
+  CHECK(!stub_get_pixel(72, 154));
+  dots_layer_destroy(dots_layer);
+  CHECK(stub_animations_alive() == 0);
+}
+
+int main(void) {
+  test_active_dot_is_hollow();
+  test_incremental_dot_count_change();
+  test_incremental_window_scroll();
+  test_animation_made_at_init();
+  return stub_failures ? 1 : 0;
+}
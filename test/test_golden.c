@@ -0,0 +1,113 @@
+// Steps flips forwards, backwards and round the end through fixed points in each drawing mode, and compares every frame with the one stored in golden/.
+// Run with GOLDEN_UPDATE set (make golden) to store the current frames instead, once you've checked a change is meant to alter them.
+#include "stub.h"
+#include "split_flap.h"
+
+#define NUM_PAGES 3
+#define NUM_STEPS 8
+#define CONTROL_RECT GRect(0, 0, 144, 100)
+
+static SplitFlapLayerPage s_pages[NUM_PAGES];
+static struct StubFont s_font = {12, 18};
+static const char* s_texts[NUM_PAGES] = {"LHR", "CDG", "JFK"};
+
+// Each page draws a bar whose position says which page it is, and a box across the split.
+static void page_update_proc(Layer* layer, GContext* ctx) {
+  for (int i = 0; i < NUM_PAGES; ++i) {
+    if (layer == s_pages[i].upperLayer || layer == s_pages[i].lowerLayer) {
+      bool lower = layer == s_pages[i].lowerLayer;
+      graphics_context_set_fill_color(ctx, GColorBlack);
+      graphics_fill_rect(ctx, GRect(8 + i * 30, lower ? 0 : 12, 14, 34), 0, GCornerNone);
+      graphics_fill_rect(ctx, GRect(100, lower ? 0 : 30, 24, 16), 4, lower ? GCornersBottom : GCornersTop);
+    }
+  }
+}
+
+typedef enum {
+  GoldenPages,
+  GoldenSnapshots,
+  GoldenIncremental,
+  GoldenText
+} GoldenMode;
+
+static const char* s_mode_names[] = {"pages", "snapshots", "incremental", "text"};
+
+static bool s_update;
+
+static void check_frame(GoldenMode mode, const char* frame_name) {
+  char path[64];
+  snprintf(path, sizeof(path), "golden/%s_%s.pbm", s_mode_names[mode], frame_name);
+  if (s_update) {
+    CHECK(stub_write_pbm(path, CONTROL_RECT));
+    return;
+  }
+  int32_t diff = stub_compare_pbm(path, CONTROL_RECT);
+  if (diff != 0) {
+    fprintf(stderr, "%s: %d pixels differ\n", path, diff);
+  }
+  CHECK(diff == 0);
+}
+
+// Steps a flip to page_idx from wherever the layer is, checking each frame against golden/<mode>_<name>_<step>.pbm.
+static void golden_step_flip(GoldenMode mode, SplitFlapLayer* split_layer, uint32_t page_idx, const char* name) {
+  CHECK(split_flap_layer_begin_flip(split_layer, page_idx));
+  char frame_name[32];
+  for (int step = 0; step <= NUM_STEPS; ++step) {
+    split_flap_layer_set_flip_progress(split_layer, step * ANIMATION_NORMALIZED_MAX / NUM_STEPS);
+    layer_mark_dirty(split_flap_layer_get_layer(split_layer));
+    stub_render();
+    snprintf(frame_name, sizeof(frame_name), "%s_%d", name, step);
+    check_frame(mode, frame_name);
+  }
+  split_flap_layer_end_flip(split_layer);
+  stub_run_until_idle(1000);
+  snprintf(frame_name, sizeof(frame_name), "%s_end", name);
+  check_frame(mode, frame_name);
+}
+
+static void golden_flip(GoldenMode mode) {
+  stub_reset(mode == GoldenIncremental ? GColorClear : GColorBlack);
+  SplitFlapLayer* split_layer = split_flap_layer_create(CONTROL_RECT);
+  if (mode == GoldenText) {
+    split_flap_layer_set_text_pages(split_layer, s_texts, NUM_PAGES, &s_font, GTextAlignmentCenter);
+  } else {
+    for (int i = 0; i < NUM_PAGES; ++i) {
+      split_flap_layer_init_page(split_layer, &s_pages[i]);
+      layer_set_update_proc(s_pages[i].upperLayer, page_update_proc);
+      layer_set_update_proc(s_pages[i].lowerLayer, page_update_proc);
+    }
+    split_flap_layer_set_pages(split_layer, s_pages, NUM_PAGES);
+    split_flap_layer_set_snapshot_mode(split_layer, mode != GoldenPages);
+    split_flap_layer_set_incremental_redraw(split_layer, mode == GoldenIncremental);
+  }
+  layer_add_child(stub_window_layer(), split_flap_layer_get_layer(split_layer));
+  // Show every page at rest first, so snapshot modes have them.
+  stub_run_until_idle(1000);
+  for (int i = NUM_PAGES - 1; i >= 0; --i) {
+    split_flap_layer_set_current_page(split_layer, i, false);
+    stub_run_until_idle(1000);
+  }
+  check_frame(mode, "rest");
+
+  // Both directions, and both ways round the end (anim_forward decides which half of which page goes where).
+  golden_step_flip(mode, split_layer, 1, "forward");
+  golden_step_flip(mode, split_layer, 0, "backward");
+  golden_step_flip(mode, split_layer, NUM_PAGES - 1, "wrap_backward");
+  golden_step_flip(mode, split_layer, 0, "wrap_forward");
+
+  if (mode != GoldenText) {
+    for (int i = 0; i < NUM_PAGES; ++i) {
+      split_flap_layer_deinit_page(&s_pages[i]);
+    }
+  }
+  split_flap_layer_destroy(split_layer);
+}
+
+int main(void) {
+  s_update = getenv("GOLDEN_UPDATE") != NULL;
+  golden_flip(GoldenPages);
+  golden_flip(GoldenSnapshots);
+  golden_flip(GoldenIncremental);
+  golden_flip(GoldenText);
+  return stub_failures ? 1 : 0;
+}
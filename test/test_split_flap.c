@@ -0,0 +1,764 @@
+#include "stub.h"
+#include "split_flap.h"
+#include "split_flap_bank.h"
+
+#define NUM_PAGES 5
+
+static SplitFlapLayerPage s_pages[NUM_PAGES];
+static uint32_t s_page_cost_ms; // How long each page half takes to draw, on the fake clock.
+static int s_page_changes;
+static int s_last_old_page;
+static int s_last_new_page;
+
+// Each page draws a bar whose position says which page it is.
+static void page_update_proc(Layer* layer, GContext* ctx) {
+  stub_clock_advance(s_page_cost_ms);
+  for (int i = 0; i < NUM_PAGES; ++i) {
+    if (layer == s_pages[i].upperLayer || layer == s_pages[i].lowerLayer) {
+      bool lower = layer == s_pages[i].lowerLayer;
+      graphics_context_set_fill_color(ctx, GColorBlack);
+      graphics_fill_rect(ctx, GRect(8 + i * 24, lower ? 0 : 12, 12, 34), 0, GCornerNone);
+      graphics_fill_rect(ctx, GRect(100, lower ? 20 : 4, 20, 6), 0, GCornerNone);
+    }
+  }
+}
+
+static void page_changed(SplitFlapLayer* split_layer, int old_page_idx, int new_page_idx) {
+  s_page_changes++;
+  s_last_old_page = old_page_idx;
+  s_last_new_page = new_page_idx;
+}
+
+static SplitFlapLayer* create_split_flap(void) {
+  stub_reset(GColorBlack);
+  SplitFlapLayer* split_layer = split_flap_layer_create(GRect(0, 0, 144, 100));
+  for (int i = 0; i < NUM_PAGES; ++i) {
+    split_flap_layer_init_page(split_layer, &s_pages[i]);
+    layer_set_update_proc(s_pages[i].upperLayer, page_update_proc);
+    layer_set_update_proc(s_pages[i].lowerLayer, page_update_proc);
+  }
+  split_flap_layer_set_pages(split_layer, s_pages, NUM_PAGES);
+  split_flap_layer_set_callbacks(split_layer, (SplitFlapLayerCallbacks){.page_changed = page_changed});
+  layer_add_child(stub_window_layer(), split_flap_layer_get_layer(split_layer));
+  s_page_changes = 0;
+  stub_run_until_idle(1000);
+  return split_layer;
+}
+
+static void destroy_split_flap(SplitFlapLayer* split_layer) {
+  for (int i = 0; i < NUM_PAGES; ++i) {
+    split_flap_layer_deinit_page(&s_pages[i]);
+  }
+  split_flap_layer_destroy(split_layer);
+}
+
+// What the control looks like sitting on page_idx, having never flipped.
+static void render_at_rest(uint32_t page_idx, uint8_t* pixels) {
+  SplitFlapLayer* split_layer = create_split_flap();
+  split_flap_layer_set_current_page(split_layer, page_idx, false);
+  stub_run_until_idle(1000);
+  stub_copy_framebuffer(pixels);
+  destroy_split_flap(split_layer);
+}
+
+// Whether a control that's finished flipping looks like it never moved.
+static uint32_t settled_diff(SplitFlapLayer* split_layer) {
+  static uint8_t settled[STUB_FRAMEBUFFER_SIZE];
+  static uint8_t expected[STUB_FRAMEBUFFER_SIZE];
+  stub_run_until_idle(2000);
+  layer_mark_dirty(split_flap_layer_get_layer(split_layer));
+  stub_render();
+  stub_copy_framebuffer(settled);
+  uint32_t page_idx = split_flap_layer_get_current_page(split_layer);
+  destroy_split_flap(split_layer);
+  render_at_rest(page_idx, expected);
+  return stub_count_diff(settled, expected, GRect(0, 0, 144, 100));
+}
+
+static void test_flip_lands_on_next_page(void) {
+  SplitFlapLayer* split_layer = create_split_flap();
+  split_flap_layer_set_current_page_by_delta(split_layer, 1, true);
+  uint32_t frames = stub_run_until_idle(1000);
+  CHECK(frames > 2);
+  CHECK(split_flap_layer_get_current_page(split_layer) == 1);
+  CHECK(s_page_changes == 1);
+  CHECK(s_last_old_page == 0 && s_last_new_page == 1);
+  destroy_split_flap(split_layer);
+}
+
+static void test_flip_backwards_wraps(void) {
+  SplitFlapLayer* split_layer = create_split_flap();
+  split_flap_layer_set_current_page_by_delta(split_layer, -1, true);
+  stub_run_until_idle(1000);
+  CHECK(split_flap_layer_get_current_page(split_layer) == NUM_PAGES - 1);
+  CHECK(s_page_changes == 1);
+  destroy_split_flap(split_layer);
+}
+
+// The flip's last frame is drawn well short of the end when the frame rate's low or the flip is quick.
+static void test_settled_page_draws_like_new(void) {
+  SplitFlapLayer* split_layer = create_split_flap();
+  stub_set_frame_interval(70);
+  split_flap_layer_set_current_page_by_delta(split_layer, 1, true);
+  CHECK(settled_diff(split_layer) == 0);
+
+  split_layer = create_split_flap();
+  stub_set_frame_interval(50);
+  split_flap_layer_set_flip_queue(split_layer, true, false);
+  split_flap_layer_set_current_page_by_delta(split_layer, 1, true);
+  split_flap_layer_set_current_page_by_delta(split_layer, 1, true);
+  split_flap_layer_set_current_page_by_delta(split_layer, 1, true);
+  CHECK(settled_diff(split_layer) == 0);
+}
+
+// The page halves, as they sit on screen at rest.
+#define HALF_W 136
+#define HALF_H 46
+#define HALF_ROW_SIZE 20
+
+#define CORNER_RAD 8
+
+static bool snapshot_get(const uint8_t* pixels, int x, int y) {
+  return (pixels[y * HALF_ROW_SIZE + x / 8] >> (x % 8)) & 1;
+}
+
+// Whether x is in the left or right corner columns, and y in the corner rows of the given half.
+static bool in_corner(int x, int y, bool lower) {
+  bool corner_x = x < CORNER_RAD || x >= HALF_W - CORNER_RAD;
+  return corner_x && (lower ? y >= HALF_H - CORNER_RAD : y < CORNER_RAD);
+}
+
+// Snapshots should be of the page at rest, whatever was going on when they were taken. The test pages don't draw in the
+// corners, so anything the background rounded off there should be white, as though the page layer were transparent.
+static void test_snapshots_of_settled_pages(void) {
+  static uint8_t snapshots[NUM_PAGES][2][HALF_H * HALF_ROW_SIZE];
+  bool valid[NUM_PAGES];
+  SplitFlapLayer* split_layer = create_split_flap();
+  split_flap_layer_set_snapshot_mode(split_layer, true);
+  split_flap_layer_set_flip_queue(split_layer, true, false);
+  stub_set_frame_interval(50);
+  for (int i = 0; i < NUM_PAGES * 2; ++i) {
+    split_flap_layer_set_current_page_by_delta(split_layer, 1, true);
+    stub_run_until_idle(1000);
+  }
+  for (int i = 0; i < NUM_PAGES; ++i) {
+    valid[i] = s_pages[i].snapshotValid;
+    if (valid[i]) {
+      memcpy(snapshots[i][0], s_pages[i].upperSnapshot->addr, sizeof(snapshots[i][0]));
+      memcpy(snapshots[i][1], s_pages[i].lowerSnapshot->addr, sizeof(snapshots[i][1]));
+    }
+  }
+  destroy_split_flap(split_layer);
+
+  for (int i = 0; i < NUM_PAGES; ++i) {
+    if (!valid[i]) continue;
+    static uint8_t expected[STUB_FRAMEBUFFER_SIZE];
+    render_at_rest(i, expected);
+    uint32_t diff = 0;
+    for (int y = 0; y < HALF_H; ++y) {
+      for (int x = 0; x < HALF_W; ++x) {
+        diff += snapshot_get(snapshots[i][0], x, y) != (in_corner(x, y, false) || stub_get_pixel(4 + x, 4 + y));
+        diff += snapshot_get(snapshots[i][1], x, y) != (in_corner(x, y, true) || stub_get_pixel(4 + x, 4 + HALF_H + y));
+      }
+    }
+    CHECK(diff == 0);
+  }
+}
+
+// The queue skips whole laps, and doesn't flip at all if it'd end up back where it started.
+static void test_flip_queue_folds_laps(void) {
+  SplitFlapLayer* split_layer = create_split_flap();
+  split_flap_layer_set_flip_queue(split_layer, true, false);
+  split_flap_layer_set_current_page_by_delta(split_layer, NUM_PAGES, true);
+  CHECK(stub_run_until_idle(1000) == 0);
+  CHECK(split_flap_layer_get_current_page(split_layer) == 0);
+  CHECK(s_page_changes == 0);
+
+  // Nearly a lap still goes forwards, skipping pages to keep up.
+  split_flap_layer_set_current_page_by_delta(split_layer, NUM_PAGES - 1, true);
+  stub_run_until_idle(1000);
+  CHECK(split_flap_layer_get_current_page(split_layer) == NUM_PAGES - 1);
+  CHECK(s_page_changes == 3);
+
+  // A lap queued up behind a flip is dropped once it ends.
+  s_page_changes = 0;
+  split_flap_layer_set_current_page_by_delta(split_layer, 1, true);
+  split_flap_layer_set_current_page_by_delta(split_layer, NUM_PAGES, true);
+  stub_run_until_idle(1000);
+  CHECK(split_flap_layer_get_current_page(split_layer) == 0);
+  CHECK(s_page_changes == 1);
+  destroy_split_flap(split_layer);
+}
+
+// The page whose bar is on screen at row y, or -1 if it isn't just the one.
+static int page_at_row(int y) {
+  int page_idx = -1;
+  for (int i = 0; i < NUM_PAGES; ++i) {
+    if (stub_get_pixel(4 + 14 + i * 24, y)) continue;
+    if (page_idx >= 0) return -1;
+    page_idx = i;
+  }
+  return page_idx;
+}
+
+// Whether page_idx's bar is what's on screen.
+static bool showing_page(uint32_t page_idx) {
+  return page_at_row(4 + 30) == (int)page_idx;
+}
+
+// The pages showing in each half of the flap, part way through the first half of each flip.
+#define MAX_FLIPS 8
+static int s_flip_upper[MAX_FLIPS];
+static int s_flip_lower[MAX_FLIPS];
+
+static void record_flip_halves(SplitFlapLayer* split_layer, const SplitFlapLayerProfile* profile, void* context) {
+  // From a quarter to half way, the flap's clear of the rows looked at.
+  if (!profile->animating || profile->anim_progress < ANIMATION_NORMALIZED_MAX / 4 || profile->anim_progress >= ANIMATION_NORMALIZED_MAX / 2) return;
+  if (s_page_changes >= MAX_FLIPS || s_flip_upper[s_page_changes] >= 0) return;
+  s_flip_upper[s_page_changes] = page_at_row(4 + 14);
+  s_flip_lower[s_page_changes] = page_at_row(4 + 46 + 30);
+}
+
+// Flips the queue through and checks each flip went from pages[i] to pages[i + 1] in the given direction.
+// Going forwards, the new page's top half drops in first; going backwards, its bottom half comes up first.
+static void check_queued_flips(const int* pages, int num_flips, bool forward) {
+  for (int i = 0; i < MAX_FLIPS; ++i) {
+    s_flip_upper[i] = s_flip_lower[i] = -1;
+  }
+  stub_run_until_idle(2000);
+  CHECK(s_page_changes == num_flips);
+  for (int i = 0; i < num_flips && i < MAX_FLIPS; ++i) {
+    CHECK(s_flip_upper[i] == (forward ? pages[i + 1] : pages[i]));
+    CHECK(s_flip_lower[i] == (forward ? pages[i] : pages[i + 1]));
+  }
+}
+
+// However many pages are queued, and however few pages there are, every flip goes the way the button was pressed.
+static void test_flip_queue_direction(void) {
+  SplitFlapLayer* split_layer = create_split_flap();
+  split_flap_layer_set_pages(split_layer, s_pages, 3);
+  split_flap_layer_set_flip_queue(split_layer, true, false);
+  split_flap_layer_set_profile_handler(split_layer, record_flip_halves, NULL);
+  stub_set_frame_interval(5);
+  stub_run_until_idle(1000);
+
+  // Held down: one flip running, two more queued behind it.
+  s_page_changes = 0;
+  split_flap_layer_set_current_page_by_delta(split_layer, 1, true);
+  split_flap_layer_set_current_page_by_delta(split_layer, 1, true);
+  split_flap_layer_set_current_page_by_delta(split_layer, 1, true);
+  check_queued_flips((const int[]){0, 1, 2, 0}, 3, true);
+
+  // Two at once from rest.
+  s_page_changes = 0;
+  split_flap_layer_set_current_page_by_delta(split_layer, 2, true);
+  check_queued_flips((const int[]){0, 1, 2}, 2, true);
+
+  // And the other way.
+  s_page_changes = 0;
+  split_flap_layer_set_current_page_by_delta(split_layer, -1, true);
+  split_flap_layer_set_current_page_by_delta(split_layer, -1, true);
+  check_queued_flips((const int[]){2, 1, 0}, 2, false);
+  s_page_changes = 0;
+  split_flap_layer_set_current_page_by_delta(split_layer, -2, true);
+  check_queued_flips((const int[]){0, 2, 1}, 2, false);
+  destroy_split_flap(split_layer);
+}
+
+static void test_pages_shown_when_set(void) {
+  SplitFlapLayer* split_layer = create_split_flap();
+  CHECK(split_flap_layer_get_current_page(split_layer) == 0);
+  CHECK(showing_page(0));
+
+  // Setting the same pages again stays put.
+  split_flap_layer_set_current_page(split_layer, 4, false);
+  split_flap_layer_set_pages(split_layer, s_pages, NUM_PAGES);
+  stub_run_until_idle(1000);
+  CHECK(split_flap_layer_get_current_page(split_layer) == 4);
+  CHECK(showing_page(4));
+
+  // Fewer pages than the current one goes back to the start.
+  split_flap_layer_set_pages(split_layer, s_pages, 3);
+  stub_run_until_idle(1000);
+  CHECK(split_flap_layer_get_current_page(split_layer) == 0);
+  CHECK(showing_page(0));
+
+  // Mid-flip too.
+  split_flap_layer_set_current_page_by_delta(split_layer, -1, true);
+  stub_run(100);
+  split_flap_layer_set_pages(split_layer, s_pages, 2);
+  stub_run_until_idle(1000);
+  CHECK(split_flap_layer_get_current_page(split_layer) == 0);
+  CHECK(showing_page(0));
+  destroy_split_flap(split_layer);
+}
+
+// Animations are made along with the layer, not when it flips - and layers that are only flipped from outside don't get one.
+static void test_animation_made_at_init(void) {
+  stub_reset(GColorBlack);
+  uint32_t created = stub_animations_created();
+  SplitFlapBank* bank = split_flap_bank_create(GRect(0, 0, 144, 60), 4);
+  CHECK(stub_animations_created() - created == 1);
+  static struct StubFont font = {6, 10};
+  static const char* texts[NUM_PAGES] = {"0", "1", "2", "3", "4"};
+  split_flap_bank_set_text_pages(bank, texts, NUM_PAGES, &font, GTextAlignmentCenter);
+  layer_add_child(stub_window_layer(), split_flap_bank_get_layer(bank));
+  uint32_t pages[4] = {1, 2, 3, 4};
+  split_flap_bank_set_pages(bank, pages, true);
+  stub_run_until_idle(2000);
+  CHECK(split_flap_bank_get_cell_page(bank, 3) == 4);
+  CHECK(stub_animations_created() - created == 1);
+  split_flap_bank_destroy(bank);
+
+  created = stub_animations_created();
+  SplitFlapLayer* split_layer = create_split_flap();
+  CHECK(stub_animations_created() - created == 1);
+  split_flap_layer_set_current_page_by_delta(split_layer, 1, true);
+  split_flap_layer_set_current_page_by_delta(split_layer, 1, true);
+  stub_run_until_idle(1000);
+  CHECK(stub_animations_created() - created == 1);
+  destroy_split_flap(split_layer);
+
+  // A driven layer asked to flip by itself just goes straight there.
+  created = stub_animations_created();
+  split_layer = split_flap_layer_create_driven(GRect(0, 0, 144, 100));
+  split_flap_layer_set_text_pages(split_layer, texts, NUM_PAGES, &font, GTextAlignmentCenter);
+  layer_add_child(stub_window_layer(), split_flap_layer_get_layer(split_layer));
+  split_flap_layer_set_current_page(split_layer, 2, true);
+  CHECK(split_flap_layer_get_current_page(split_layer) == 2);
+  CHECK(stub_run_until_idle(1000) == 1);
+  CHECK(stub_animations_created() == created);
+  split_flap_layer_destroy(split_layer);
+  CHECK(stub_animations_alive() == 0);
+}
+
+// Every frame of a flip puts the corners back, except in incremental mode, where frames that don't touch a corner leave the mask alone.
+// A page at rest drawn from its snapshot already has its corners cut out, so it doesn't need the mask either.
+static void test_mask_redraws(void) {
+  SplitFlapLayer* split_layer = create_split_flap();
+  split_flap_layer_set_snapshot_mode(split_layer, true);
+  for (int i = 0; i < 2; ++i) {
+    split_flap_layer_set_current_page_by_delta(split_layer, 1, true);
+    stub_run_until_idle(1000);
+  }
+  split_flap_layer_reset_stats(split_layer);
+  split_flap_layer_set_current_page_by_delta(split_layer, -1, true);
+  stub_run_until_idle(1000);
+  const SplitFlapLayerStats* stats = split_flap_layer_get_stats(split_layer);
+  CHECK(stats->flip_frames > 2);
+  CHECK(stats->frames == stats->flip_frames + 1);
+  CHECK(stats->mask_redraws == stats->flip_frames);
+
+  split_flap_layer_set_incremental_redraw(split_layer, true);
+  split_flap_layer_reset_stats(split_layer);
+  split_flap_layer_set_current_page_by_delta(split_layer, 1, true);
+  stub_run_until_idle(1000);
+  CHECK(stats->frames > 2);
+  CHECK(stats->mask_redraws > 0 && stats->mask_redraws < stats->frames);
+  // And the corners still come out right.
+  CHECK(settled_diff(split_layer) == 0);
+}
+
+static void flip_twice(SplitFlapLayer* split_layer) {
+  for (int i = 0; i < 2; ++i) {
+    split_flap_layer_set_current_page_by_delta(split_layer, 1, true);
+    stub_run_until_idle(1000);
+  }
+}
+
+// Snapshot buffers are made when the pages or size are set, never while drawing - if there aren't any, pages draw the slow way.
+static void test_snapshots_not_allocated_drawing(void) {
+  SplitFlapLayer* split_layer = create_split_flap();
+  split_flap_layer_set_snapshot_mode(split_layer, true);
+  flip_twice(split_layer);
+  CHECK(s_pages[1].snapshotValid);
+  CHECK(stub_draw_allocations() == 0);
+
+  // Resized behind its back, the buffers are the wrong size - and drawing doesn't replace them.
+  layer_set_frame(split_flap_layer_get_layer(split_layer), GRect(0, 0, 144, 120));
+  flip_twice(split_layer);
+  CHECK(stub_draw_allocations() == 0);
+  CHECK(s_pages[3].upperSnapshot->bounds.size.h != 56);
+  CHECK(!s_pages[3].snapshotValid);
+
+  split_flap_layer_set_frame(split_layer, GRect(0, 0, 144, 120));
+  CHECK(s_pages[3].upperSnapshot->bounds.size.h == 56);
+  flip_twice(split_layer);
+  CHECK(stub_draw_allocations() == 0);
+  CHECK(s_pages[0].snapshotValid);
+
+  // Out of heap: no buffers, and no trying again every frame.
+  split_flap_layer_set_snapshot_mode(split_layer, false);
+  stub_set_malloc_fails(true);
+  split_flap_layer_set_snapshot_mode(split_layer, true);
+  stub_set_malloc_fails(false);
+  CHECK(!s_pages[0].upperSnapshot);
+  flip_twice(split_layer);
+  CHECK(stub_draw_allocations() == 0);
+  CHECK(!s_pages[0].upperSnapshot && !s_pages[0].snapshotValid);
+  destroy_split_flap(split_layer);
+}
+
+// The flap positions drawn during a flip, going by the profile.
+#define MAX_FLIP_FRAMES 256
+static uint32_t s_flip_steps[MAX_FLIP_FRAMES];
+static uint32_t s_num_flip_steps;
+
+static void record_flip_step(SplitFlapLayer* split_layer, const SplitFlapLayerProfile* profile, void* context) {
+  if (profile->animating && s_num_flip_steps < MAX_FLIP_FRAMES) {
+    s_flip_steps[s_num_flip_steps++] = (profile->anim_progress + 512) / 1024;
+  }
+}
+
+// Flips once on the given battery, ticking the animation every millisecond, and returns how many frames of it were drawn.
+static uint32_t governed_flip(bool enabled, SplitFlapGovernor governor, BatteryChargeState battery, uint32_t page_cost_ms) {
+  SplitFlapLayer* split_layer = create_split_flap();
+  stub_set_battery(battery);
+  split_flap_layer_set_governor(split_layer, enabled, governor);
+  split_flap_layer_set_profile_handler(split_layer, record_flip_step, NULL);
+  stub_set_frame_interval(1);
+  s_page_cost_ms = page_cost_ms;
+  s_num_flip_steps = 0;
+  split_flap_layer_set_current_page_by_delta(split_layer, 1, true);
+  stub_run_until_idle(2000);
+  s_page_cost_ms = 0;
+  destroy_split_flap(split_layer);
+  return s_num_flip_steps;
+}
+
+// Whether every frame drawn moved the flap to a new position a multiple of stride steps along.
+static bool flip_steps_on_stride(uint32_t first, uint32_t stride) {
+  for (uint32_t i = first; i < s_num_flip_steps; ++i) {
+    uint32_t step = (s_flip_steps[i] + stride / 2) / stride;
+    uint32_t last = i ? (s_flip_steps[i - 1] + stride / 2) / stride : UINT32_MAX;
+    if (step == last) return false;
+  }
+  return true;
+}
+
+// Blank pages on a driven layer, for looking at the flap on its own.
+static SplitFlapLayer* create_blank_split_flap(GRect frame) {
+  stub_reset(GColorBlack);
+  SplitFlapLayer* split_layer = split_flap_layer_create_driven(frame);
+  for (int i = 0; i < NUM_PAGES; ++i) {
+    split_flap_layer_init_page(split_layer, &s_pages[i]);
+  }
+  split_flap_layer_set_pages(split_layer, s_pages, NUM_PAGES);
+  split_flap_layer_set_easing(split_layer, SplitFlapEasingLinear);
+  layer_add_child(stub_window_layer(), split_flap_layer_get_layer(split_layer));
+  stub_run_until_idle(1000);
+  return split_layer;
+}
+
+// The flap's height is worked out for flaps of any size, from too small for corners to taller than a byte.
+static void test_flap_geometry_extremes(void) {
+  // 1px of flap, so no half to scale the corners by.
+  SplitFlapLayer* split_layer = create_blank_split_flap(GRect(0, 0, 144, 9));
+  CHECK(split_flap_layer_begin_flip(split_layer, 1));
+  split_flap_layer_set_flip_progress(split_layer, ANIMATION_NORMALIZED_MAX / 4);
+  layer_mark_dirty(split_flap_layer_get_layer(split_layer));
+  CHECK(stub_render());
+  split_flap_layer_end_flip(split_layer);
+  CHECK(split_flap_layer_get_current_page(split_layer) == 1);
+  destroy_split_flap(split_layer);
+
+  // A 592px flap with its split in the middle of the screen. At the start of a flip the flap covers the whole of its half, so its border
+  // is off screen, and everything but the split is flap.
+  split_layer = create_blank_split_flap(GRect(0, -216, 144, 600));
+  CHECK(split_flap_layer_begin_flip(split_layer, 1));
+  split_flap_layer_set_flip_progress(split_layer, 0);
+  layer_mark_dirty(split_flap_layer_get_layer(split_layer));
+  stub_render();
+  uint32_t black = 0;
+  for (int y = 0; y < STUB_SCREEN_H; ++y) {
+    if (y >= 82 && y < 86) continue; // The split.
+    for (int x = 10; x < 134; ++x) {
+      black += !stub_get_pixel(x, y);
+    }
+  }
+  CHECK(black == 0);
+  split_flap_layer_end_flip(split_layer);
+  destroy_split_flap(split_layer);
+}
+
+static void test_governor(void) {
+  SplitFlapGovernor governor = {.frame_budget_ms = 8, .low_battery_percent = 20};
+  BatteryChargeState full = {.charge_percent = 100};
+  BatteryChargeState low = {.charge_percent = 10};
+  BatteryChargeState charging = {.charge_percent = 10, .is_charging = true};
+  // Without it, every tick's drawn.
+  uint32_t ungoverned = governed_flip(false, governor, full, 0);
+  CHECK(ungoverned > 150);
+
+  // Cheap frames: only ticks that move the flap.
+  uint32_t frames = governed_flip(true, governor, full, 0);
+  CHECK(frames <= 65 && frames > 32);
+  CHECK(flip_steps_on_stride(0, 1));
+
+  // Low battery: a quarter of the positions at most, unless it's charging.
+  frames = governed_flip(true, governor, low, 0);
+  CHECK(frames <= 17 && frames > 8);
+  CHECK(flip_steps_on_stride(0, 4));
+  CHECK(governed_flip(true, governor, charging, 0) > 32);
+
+  // Frames well over budget: the stride climbs to 8 within a few frames, and stays there.
+  uint32_t slow_ungoverned = governed_flip(false, governor, full, 10);
+  frames = governed_flip(true, governor, full, 10);
+  CHECK(frames <= slow_ungoverned);
+  CHECK(frames > 4);
+  CHECK(flip_steps_on_stride(4, 8));
+}
+
+static uint32_t s_overdraw;
+
+static void record_overdraw(SplitFlapLayer* split_layer, const SplitFlapLayerProfile* profile, void* context) {
+  s_overdraw = profile->overdraw_pixels;
+}
+
+// The profile's overdraw is the control's own, whatever the pages draw.
+static void test_overdraw_leaves_out_pages(void) {
+  SplitFlapLayer* split_layer = create_split_flap();
+  split_flap_layer_set_profile_handler(split_layer, record_overdraw, NULL);
+  layer_mark_dirty(split_flap_layer_get_layer(split_layer));
+  stub_render();
+  uint32_t with_pages = s_overdraw;
+  destroy_split_flap(split_layer);
+
+  stub_reset(GColorBlack);
+  split_layer = split_flap_layer_create(GRect(0, 0, 144, 100));
+  split_flap_layer_set_pages(split_layer, NULL, 0);
+  split_flap_layer_set_profile_handler(split_layer, record_overdraw, NULL);
+  s_overdraw = 0;
+  layer_add_child(stub_window_layer(), split_flap_layer_get_layer(split_layer));
+  stub_render();
+  CHECK(s_overdraw == with_pages);
+  split_flap_layer_destroy(split_layer);
+}
+
+static void test_bank_with_no_cells(void) {
+  stub_reset(GColorBlack);
+  CHECK(split_flap_bank_create(GRect(0, 0, 144, 60), 0) == NULL);
+  SplitFlapBank* bank = split_flap_bank_create(GRect(0, 0, 144, 60), 4);
+  CHECK(bank != NULL);
+  split_flap_bank_destroy(bank);
+}
+
+#define BANK_FRAMES 10
+static struct StubFont s_bank_font = {12, 20};
+static const char* s_bank_texts[NUM_PAGES] = {"0", "1", "2", "3", "4"};
+
+// A cell is drawn just like a SplitFlapLayer with the same text pages, at rest and every frame of a flip.
+static void test_bank_draws_like_split_flap(void) {
+  static uint8_t expected[BANK_FRAMES][STUB_FRAMEBUFFER_SIZE];
+  static uint8_t drawn[STUB_FRAMEBUFFER_SIZE];
+  stub_reset(GColorBlack);
+  SplitFlapLayer* split_layer = split_flap_layer_create(GRect(0, 0, 144, 100));
+  split_flap_layer_set_text_pages(split_layer, s_bank_texts, NUM_PAGES, &s_bank_font, GTextAlignmentCenter);
+  layer_add_child(stub_window_layer(), split_flap_layer_get_layer(split_layer));
+  stub_run_until_idle(1000);
+  split_flap_layer_set_current_page(split_layer, 1, true);
+  for (int i = 0; i < BANK_FRAMES; ++i) {
+    stub_run(STUB_FRAME_MS);
+    stub_copy_framebuffer(expected[i]);
+  }
+  split_flap_layer_destroy(split_layer);
+
+  stub_reset(GColorBlack);
+  SplitFlapBank* bank = split_flap_bank_create(GRect(0, 0, 144, 100), 1);
+  split_flap_bank_set_text_pages(bank, s_bank_texts, NUM_PAGES, &s_bank_font, GTextAlignmentCenter);
+  layer_add_child(stub_window_layer(), split_flap_bank_get_layer(bank));
+  stub_run_until_idle(1000);
+  split_flap_bank_set_cell_page(bank, 0, 1, true);
+  for (int i = 0; i < BANK_FRAMES; ++i) {
+    stub_run(STUB_FRAME_MS);
+    stub_copy_framebuffer(drawn);
+    CHECK(stub_count_diff(expected[i], drawn, GRect(0, 0, 144, 100)) == 0);
+  }
+  CHECK(split_flap_bank_get_cell_page(bank, 0) == 1);
+  split_flap_bank_destroy(bank);
+}
+
+static SplitFlapBank* create_text_bank(uint32_t num_cells) {
+  stub_reset(GColorBlack);
+  SplitFlapBank* bank = split_flap_bank_create(GRect(0, 0, 144, 60), num_cells);
+  split_flap_bank_set_text_pages(bank, s_bank_texts, NUM_PAGES, &s_bank_font, GTextAlignmentCenter);
+  layer_add_child(stub_window_layer(), split_flap_bank_get_layer(bank));
+  stub_run_until_idle(1000);
+  return bank;
+}
+
+// The cells share the bank's one layer, and a cell only takes memory while it's flipping - the snapshots for one flip at a time are
+// made when it starts, and kept for the next.
+static void test_bank_memory_follows_flips(void) {
+  SplitFlapBank* bank = create_text_bank(4);
+  uint32_t small_bank = stub_allocations();
+  split_flap_bank_destroy(bank);
+  bank = create_text_bank(12);
+  CHECK(stub_allocations() == small_bank);
+  CHECK(stub_last_frame()->layer_draws == 1);
+
+  split_flap_bank_set_cell_page(bank, 0, 1, true);
+  uint32_t one_flip = stub_allocations() - small_bank;
+  CHECK(one_flip > 0);
+  stub_run_until_idle(1000);
+  split_flap_bank_set_cell_page(bank, 5, 1, true);
+  stub_run_until_idle(1000);
+  CHECK(stub_allocations() - small_bank == one_flip);
+
+  uint32_t pages[12] = {2, 2, 2, 2, 0, 1};
+  split_flap_bank_set_pages(bank, pages, true);
+  CHECK(stub_allocations() - small_bank == one_flip * 4);
+  stub_run_until_idle(1000);
+  CHECK(stub_draw_allocations() == 0);
+  CHECK(split_flap_bank_get_cell_page(bank, 3) == 2);
+  CHECK(split_flap_bank_get_cell_page(bank, 4) == 0 && split_flap_bank_get_cell_page(bank, 5) == 1);
+  split_flap_bank_destroy(bank);
+}
+
+// Each cell starts its flip stagger_ms after the one before it, and a cell with nothing to flip with just goes straight there.
+static void test_bank_stagger(void) {
+  SplitFlapBank* bank = create_text_bank(4);
+  split_flap_bank_set_stagger(bank, 100);
+  uint32_t pages[4] = {3, 3, 3, 3};
+  split_flap_bank_set_pages(bank, pages, true);
+  stub_run(250);
+  CHECK(split_flap_bank_get_cell_page(bank, 0) == 3);
+  CHECK(split_flap_bank_get_cell_page(bank, 1) == 0);
+  CHECK(split_flap_bank_get_cell_page(bank, 3) == 0);
+  stub_run_until_idle(1000);
+  CHECK(split_flap_bank_get_cell_page(bank, 3) == 3);
+  CHECK(stub_clock_ms() >= 300 + 200); // The last cell's delay, and its flip.
+
+  split_flap_bank_set_cell_page(bank, 2, NUM_PAGES, true);
+  CHECK(split_flap_bank_get_cell_page(bank, 2) == 3);
+  split_flap_bank_destroy(bank);
+
+  bank = create_text_bank(4);
+  stub_set_malloc_fails(true);
+  split_flap_bank_set_cell_page(bank, 2, 1, true);
+  stub_set_malloc_fails(false);
+  CHECK(split_flap_bank_get_cell_page(bank, 2) == 1);
+  CHECK(stub_run_until_idle(1000) == 1);
+  split_flap_bank_destroy(bank);
+}
+
+#define NUM_SOURCE_PAGES 1000
+#define MAX_CONFIGURES 16
+static uint32_t s_configured[MAX_CONFIGURES]; // The page index of each configure_page call.
+static SplitFlapLayerPage* s_configured_pages[MAX_CONFIGURES];
+static uint32_t s_num_configured;
+static uint32_t s_configured_while_drawing;
+
+static uint32_t source_get_num_pages(SplitFlapLayer* split_layer, void* context) {
+  return NUM_SOURCE_PAGES;
+}
+
+static void source_configure_page(SplitFlapLayer* split_layer, SplitFlapLayerPage* page, uint32_t page_idx, void* context) {
+  if (s_num_configured < MAX_CONFIGURES) {
+    s_configured[s_num_configured] = page_idx;
+    s_configured_pages[s_num_configured] = page;
+  }
+  s_num_configured++;
+  s_configured_while_drawing += stub_drawing();
+}
+
+// How many different pages the data source has been handed.
+static uint32_t distinct_configured_pages(void) {
+  uint32_t distinct = 0;
+  for (uint32_t i = 0; i < s_num_configured && i < MAX_CONFIGURES; ++i) {
+    uint32_t j = 0;
+    while (j < i && s_configured_pages[j] != s_configured_pages[i]) ++j;
+    distinct += j == i;
+  }
+  return distinct;
+}
+
+// Thousands of pages, three SplitFlapLayerPages: each page is configured when it's first needed, and recycled once it's not.
+static void test_data_source_pool(void) {
+  stub_reset(GColorBlack);
+  s_num_configured = 0;
+  s_configured_while_drawing = 0;
+  SplitFlapLayer* split_layer = split_flap_layer_create(GRect(0, 0, 144, 100));
+  split_flap_layer_set_snapshot_mode(split_layer, true);
+  split_flap_layer_set_data_source(split_layer, (SplitFlapLayerDataSource){
+    .get_num_pages = source_get_num_pages,
+    .configure_page = source_configure_page
+  }, NULL);
+  layer_add_child(stub_window_layer(), split_flap_layer_get_layer(split_layer));
+  stub_run_until_idle(1000);
+  CHECK(s_num_configured == 1 && s_configured[0] == 0);
+
+  // Forwards and back again: page 0 is still bound, so it isn't configured again.
+  split_flap_layer_set_current_page_by_delta(split_layer, 1, true);
+  stub_run_until_idle(1000);
+  split_flap_layer_set_current_page_by_delta(split_layer, -1, true);
+  stub_run_until_idle(1000);
+  CHECK(s_num_configured == 2 && s_configured[1] == 1);
+
+  // Further afield, the pool fills up and then recycles the page that's neither showing nor just left.
+  split_flap_layer_set_current_page(split_layer, 500, true);
+  stub_run_until_idle(1000);
+  split_flap_layer_set_current_page(split_layer, 999, true);
+  stub_run_until_idle(1000);
+  CHECK(s_num_configured == 4 && s_configured[2] == 500 && s_configured[3] == 999);
+  CHECK(s_configured_pages[3] != s_configured_pages[2]);
+  CHECK(distinct_configured_pages() == 3);
+  CHECK(split_flap_layer_get_current_page(split_layer) == 999);
+  // Pages are bound as flips start, so drawing them never runs the data source.
+  CHECK(s_configured_while_drawing == 0);
+
+  // There's no page 1000 to go to.
+  split_flap_layer_set_current_page(split_layer, NUM_SOURCE_PAGES, false);
+  split_flap_layer_set_current_page(split_layer, NUM_SOURCE_PAGES, true);
+  stub_run_until_idle(1000);
+  CHECK(split_flap_layer_get_current_page(split_layer) == 999);
+  CHECK(s_num_configured == 4);
+
+  // Invalidating pages that aren't bound (or don't exist) configures nothing and evicts nothing, even mid-flip.
+  split_flap_layer_set_current_page(split_layer, 500, true);
+  stub_run(50);
+  uint32_t configured = s_num_configured;
+  split_flap_layer_invalidate_page(split_layer, 6);
+  split_flap_layer_invalidate_page(split_layer, NUM_SOURCE_PAGES + 6);
+  CHECK(s_num_configured == configured);
+  split_flap_layer_invalidate_page(split_layer, 500);
+  stub_run_until_idle(1000);
+  split_flap_layer_set_current_page(split_layer, 999, true);
+  stub_run_until_idle(1000);
+  CHECK(s_num_configured == configured);
+  split_flap_layer_destroy(split_layer);
+}
+
+// Out of range pages are none of the layer's business.
+static void test_invalidate_page_bounds(void) {
+  SplitFlapLayer* split_layer = create_split_flap();
+  split_flap_layer_set_pages(split_layer, s_pages, 3);
+  s_pages[3].snapshotValid = true;
+  split_flap_layer_invalidate_page(split_layer, 3);
+  CHECK(s_pages[3].snapshotValid);
+  s_pages[3].snapshotValid = false;
+  destroy_split_flap(split_layer);
+}
+
+int main(void) {
+  test_pages_shown_when_set();
+  test_flip_lands_on_next_page();
+  test_settled_page_draws_like_new();
+  test_snapshots_of_settled_pages();
+  test_flip_backwards_wraps();
+  test_flip_queue_folds_laps();
+  test_flip_queue_direction();
+  test_bank_with_no_cells();
+  test_bank_draws_like_split_flap();
+  test_bank_memory_follows_flips();
+  test_bank_stagger();
+  test_mask_redraws();
+  test_snapshots_not_allocated_drawing();
+  test_flap_geometry_extremes();
+  test_governor();
+  test_overdraw_leaves_out_pages();
+  test_animation_made_at_init();
+  test_data_source_pool();
+  test_invalidate_page_bounds();
+  return stub_failures ? 1 : 0;
+}
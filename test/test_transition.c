@@ -0,0 +1,238 @@
+#include "stub.h"
+#include "transition.h"
+
+#define NUM_PAGES 3
+#define FLAP_FRAME GRect(0, 0, 144, 100)
+#define DOTS_FRAME GRect(0, 150, 144, 10)
+#define DOTS_STRIP GRect(0, 140, 144, 28)
+
+static struct StubFont s_font = {12, 18};
+static const char* s_texts[NUM_PAGES] = {"LHR", "CDG", "JFK"};
+
+// Everything the probe clients and the split flap get up to, in order: "Ab1" for probe A beginning a change to page 1, "Ae" for
+// it ending, and "F01" for the split flap landing on page 1 from page 0.
+static char s_log[256];
+
+static void log_event(const char* event) {
+  strncat(s_log, event, sizeof(s_log) - strlen(s_log) - 1);
+}
+
+// A client that just notes what it's asked to do.
+typedef struct Probe {
+  char name;
+  bool refuse; // Say there's nothing to do.
+  uint32_t time_normal;
+  uint32_t updates;
+} Probe;
+
+static bool probe_begin(void* client, uint32_t page_idx) {
+  Probe* probe = client;
+  char event[8];
+  snprintf(event, sizeof(event), "%cb%u ", probe->name, (unsigned)page_idx);
+  log_event(event);
+  probe->time_normal = 0;
+  return !probe->refuse;
+}
+
+static void probe_set_progress(void* client, uint32_t time_normal) {
+  Probe* probe = client;
+  probe->time_normal = time_normal;
+  probe->updates++;
+}
+
+static void probe_end(void* client) {
+  Probe* probe = client;
+  char event[8];
+  snprintf(event, sizeof(event), "%ce ", probe->name);
+  log_event(event);
+}
+
+static const TransitionClientImplementation s_probe_implementation = {
+  .begin = probe_begin,
+  .set_progress = probe_set_progress,
+  .end = probe_end
+};
+
+static void page_changed(SplitFlapLayer* split_layer, int old_page_idx, int new_page_idx) {
+  char event[8];
+  snprintf(event, sizeof(event), "F%d%d ", old_page_idx, new_page_idx);
+  log_event(event);
+}
+
+static SplitFlapLayer* s_split_layer;
+static DotsLayer* s_dots_layer;
+
+static Transition* create_transition(void) {
+  stub_reset(GColorBlack);
+  s_log[0] = '\0';
+  s_split_layer = split_flap_layer_create_driven(FLAP_FRAME);
+  split_flap_layer_set_text_pages(s_split_layer, s_texts, NUM_PAGES, &s_font, GTextAlignmentCenter);
+  split_flap_layer_set_easing(s_split_layer, SplitFlapEasingLinear);
+  split_flap_layer_set_callbacks(s_split_layer, (SplitFlapLayerCallbacks){.page_changed = page_changed});
+  layer_add_child(stub_window_layer(), split_flap_layer_get_layer(s_split_layer));
+  s_dots_layer = dots_layer_create_driven(DOTS_FRAME);
+  dots_layer_update(s_dots_layer, NUM_PAGES, 0);
+  layer_add_child(stub_window_layer(), dots_layer_get_layer(s_dots_layer));
+  stub_run_until_idle(1000);
+
+  Transition* transition = transition_create(stub_window_layer());
+  transition_add_split_flap_layer(transition, s_split_layer);
+  transition_add_dots_layer(transition, s_dots_layer);
+  return transition;
+}
+
+static void destroy_transition(Transition* transition) {
+  transition_destroy(transition);
+  dots_layer_destroy(s_dots_layer);
+  split_flap_layer_destroy(s_split_layer);
+}
+
+// What each frame of a transition drew: the time_normal its clients were given, the split flap's progress, and the dot strip.
+#define MAX_FRAMES 32
+static Probe* s_clock_probe;
+static uint32_t s_num_frames;
+static uint32_t s_frame_time_normal[MAX_FRAMES];
+static uint32_t s_frame_flap_progress[MAX_FRAMES];
+static bool s_frame_flap_animating[MAX_FRAMES];
+static uint8_t s_frame_pixels[MAX_FRAMES][STUB_FRAMEBUFFER_SIZE];
+
+static void record_flap(SplitFlapLayer* split_layer, const SplitFlapLayerProfile* profile, void* context) {
+  if (s_num_frames >= MAX_FRAMES) return;
+  s_frame_flap_animating[s_num_frames] = profile->animating;
+  s_frame_flap_progress[s_num_frames] = profile->anim_progress;
+}
+
+// The dots are drawn after the split flap, so this is the end of the frame.
+static void record_dots(DotsLayer* dots_layer, const DotsLayerProfile* profile, void* context) {
+  if (s_num_frames >= MAX_FRAMES) return;
+  s_frame_time_normal[s_num_frames] = s_clock_probe->time_normal;
+  stub_copy_framebuffer(s_frame_pixels[s_num_frames]);
+  s_num_frames++;
+}
+
+// What a DotsLayer slid by hand to time_normal of the way from one dot to another looks like.
+static void render_dots_at(int32_t from, int32_t to, uint32_t time_normal, uint8_t* pixels) {
+  stub_reset(GColorBlack);
+  DotsLayer* dots_layer = dots_layer_create_driven(DOTS_FRAME);
+  dots_layer_update(dots_layer, NUM_PAGES, from);
+  layer_add_child(stub_window_layer(), dots_layer_get_layer(dots_layer));
+  stub_run_until_idle(1000);
+  dots_layer_begin_slide(dots_layer, to);
+  dots_layer_set_slide_progress(dots_layer, time_normal);
+  layer_mark_dirty(dots_layer_get_layer(dots_layer));
+  stub_render();
+  stub_copy_framebuffer(pixels);
+  dots_layer_destroy(dots_layer);
+}
+
+// Every tick moves the flap and the dots to the same point, and redraws the window once for the lot.
+static void test_clients_move_together(void) {
+  Transition* transition = create_transition();
+  Probe clock = {.name = 'A'};
+  s_clock_probe = &clock;
+  transition_add_client(transition, &s_probe_implementation, &clock);
+  split_flap_layer_set_profile_handler(s_split_layer, record_flap, NULL);
+  dots_layer_set_profile_handler(s_dots_layer, record_dots, NULL);
+  stub_set_frame_interval(20);
+  s_num_frames = 0;
+
+  transition_set_page(transition, 2);
+  CHECK(stub_animations_alive() == 1);
+  uint32_t flip_frames = 0;
+  while (transition_is_running(transition)) {
+    uint32_t frames = stub_frames_drawn();
+    stub_run(20);
+    CHECK(stub_frames_drawn() == frames + 1);
+    if (transition_is_running(transition)) {
+      // The clients leave the marking to the transition - the first frame also has the appearing page being bound, so isn't counted.
+      if (flip_frames > 0) CHECK(stub_last_frame()->dirty_marks == 1);
+      CHECK(s_frame_flap_animating[s_num_frames - 1]);
+      CHECK(s_frame_flap_progress[s_num_frames - 1] == clock.time_normal);
+      flip_frames++;
+    }
+  }
+  CHECK(flip_frames > 4);
+  CHECK(clock.updates == s_num_frames);
+  CHECK(split_flap_layer_get_current_page(s_split_layer) == 2);
+  destroy_transition(transition);
+
+  // The dots on each frame are where a slide at that frame's time_normal puts them.
+  static uint8_t expected[STUB_FRAMEBUFFER_SIZE];
+  for (uint32_t i = 0; i < s_num_frames; ++i) {
+    render_dots_at(0, 2, s_frame_time_normal[i], expected);
+    CHECK(stub_count_diff(s_frame_pixels[i], expected, DOTS_STRIP) == 0);
+  }
+}
+
+// A new page mid-transition lands everyone on the old one first.
+static void test_page_change_settles_first(void) {
+  Transition* transition = create_transition();
+  Probe a = {.name = 'A'};
+  Probe b = {.name = 'B'};
+  transition_add_client(transition, &s_probe_implementation, &a);
+  transition_add_client(transition, &s_probe_implementation, &b);
+  transition_set_page(transition, 1);
+  stub_run(100);
+  CHECK(transition_is_running(transition));
+  transition_set_page(transition, 2);
+  stub_run_until_idle(1000);
+  CHECK(strcmp(s_log, "Ab1 Bb1 F01 Ae Be Ab2 Bb2 F12 Ae Be ") == 0);
+  CHECK(split_flap_layer_get_current_page(s_split_layer) == 2);
+  destroy_transition(transition);
+}
+
+// A client with nothing to do isn't moved or ended, and if nobody has anything to do, nothing runs.
+static void test_idle_client_left_alone(void) {
+  Transition* transition = create_transition();
+  Probe a = {.name = 'A'};
+  Probe refuser = {.name = 'R', .refuse = true};
+  transition_add_client(transition, &s_probe_implementation, &a);
+  transition_add_client(transition, &s_probe_implementation, &refuser);
+  transition_set_page(transition, 1);
+  stub_run_until_idle(1000);
+  CHECK(strcmp(s_log, "Ab1 Rb1 F01 Ae ") == 0);
+  CHECK(a.updates > 0);
+  CHECK(refuser.updates == 0);
+
+  // Already there.
+  s_log[0] = '\0';
+  a.refuse = true;
+  transition_set_page(transition, 1);
+  CHECK(!transition_is_running(transition));
+  CHECK(stub_run_until_idle(1000) == 0);
+  CHECK(strcmp(s_log, "Ab1 Rb1 ") == 0);
+  destroy_transition(transition);
+}
+
+// Only so many clients fit, and the one that doesn't is told so and left where it is.
+static void test_client_limit(void) {
+  Transition* transition = create_transition();
+  Probe probes[TRANSITION_MAX_CLIENTS - 1];
+  for (int i = 0; i < TRANSITION_MAX_CLIENTS - 2; ++i) {
+    probes[i] = (Probe){.name = 'A' + i};
+    CHECK(transition_add_client(transition, &s_probe_implementation, &probes[i]));
+  }
+  // The split flap and the dots make it full; one more is too many.
+  probes[TRANSITION_MAX_CLIENTS - 2] = (Probe){.name = 'X'};
+  CHECK(!transition_add_client(transition, &s_probe_implementation, &probes[TRANSITION_MAX_CLIENTS - 2]));
+  DotsLayer* extra_dots = dots_layer_create_driven(DOTS_FRAME);
+  dots_layer_update(extra_dots, NUM_PAGES, 0);
+  CHECK(!transition_add_dots_layer(transition, extra_dots));
+  CHECK(!transition_add_split_flap_layer(transition, s_split_layer));
+
+  transition_set_page(transition, 1);
+  stub_run_until_idle(1000);
+  CHECK(strchr(s_log, 'X') == NULL);
+  CHECK(probes[TRANSITION_MAX_CLIENTS - 2].updates == 0);
+  CHECK(split_flap_layer_get_current_page(s_split_layer) == 1);
+  dots_layer_destroy(extra_dots);
+  destroy_transition(transition);
+}
+
+int main(void) {
+  test_clients_move_together();
+  test_page_change_settles_first();
+  test_idle_client_left_alone();
+  test_client_limit();
+  return stub_failures ? 1 : 0;
+}
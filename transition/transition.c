@@ -0,0 +1,155 @@
+#include <pebble.h>
+#include "transition.h"
+
+static const int TRANSITION_DEFAULT_DURATION = 200; // msec, same as a SplitFlapLayer's own flips
+
+typedef struct TransitionClient {
+  const TransitionClientImplementation* implementation;
+  void* client;
+  bool active; // Taking part in the current page change.
+} TransitionClient;
+
+typedef struct Transition {
+  Layer* layer;
+  Animation* anim;
+  uint32_t duration;
+  TransitionClient clients[TRANSITION_MAX_CLIENTS];
+  uint8_t num_clients;
+} Transition;
+
+static void transition_animation_update(Animation* animation, const uint32_t time_normal) {
+  Transition* transition = (Transition*)animation_get_context(animation);
+  // Everyone moves to the same point...
+  for (int i = 0; i < transition->num_clients; ++i) {
+    TransitionClient* client = &transition->clients[i];
+    if (client->active) {
+      client->implementation->set_progress(client->client, time_normal);
+    }
+  }
+  // ...and gets drawn in the same frame.
+  layer_mark_dirty(transition->layer);
+}
+
+static void transition_animation_stopped(Animation* animation, bool finished, void* context) {
+  Transition* transition = (Transition*)context;
+  // Finished or not, everyone ends up on the new page.
+  for (int i = 0; i < transition->num_clients; ++i) {
+    TransitionClient* client = &transition->clients[i];
+    if (client->active) {
+      client->active = false;
+      client->implementation->end(client->client);
+    }
+  }
+  layer_mark_dirty(transition->layer);
+}
+
+static const AnimationImplementation transition_animation_implementation = {
+  .setup = NULL,
+  .update = transition_animation_update,
+  .teardown = NULL
+};
+
+// Adapters for the controls in this repo.
+static bool transition_split_flap_begin(void* client, uint32_t page_idx) {
+  return split_flap_layer_begin_flip((SplitFlapLayer*)client, page_idx);
+}
+
+static void transition_split_flap_set_progress(void* client, uint32_t time_normal) {
+  split_flap_layer_set_flip_progress((SplitFlapLayer*)client, time_normal);
+}
+
+static void transition_split_flap_end(void* client) {
+  split_flap_layer_end_flip((SplitFlapLayer*)client);
+}
+
+static const TransitionClientImplementation transition_split_flap_implementation = {
+  .begin = transition_split_flap_begin,
+  .set_progress = transition_split_flap_set_progress,
+  .end = transition_split_flap_end
+};
+
+static bool transition_dots_begin(void* client, uint32_t page_idx) {
+  return dots_layer_begin_slide((DotsLayer*)client, page_idx);
+}
+
+static void transition_dots_set_progress(void* client, uint32_t time_normal) {
+  dots_layer_set_slide_progress((DotsLayer*)client, time_normal);
+}
+
+static void transition_dots_end(void* client) {
+  dots_layer_end_slide((DotsLayer*)client);
+}
+
+static const TransitionClientImplementation transition_dots_implementation = {
+  .begin = transition_dots_begin,
+  .set_progress = transition_dots_set_progress,
+  .end = transition_dots_end
+};
+
+Transition* transition_create(Layer* layer) {
+  Transition* transition = malloc(sizeof(Transition));
+  if (!transition) return NULL;
+  memset(transition, 0, sizeof(Transition));
+  transition->layer = layer;
+  transition->duration = TRANSITION_DEFAULT_DURATION;
+
+  transition->anim = animation_create();
+  if (!transition->anim) {
+    free(transition);
+    return NULL;
+  }
+  AnimationHandlers callbacks = {
+    .started = NULL,
+    .stopped = transition_animation_stopped
+  };
+  animation_set_handlers(transition->anim, callbacks, transition);
+  animation_set_implementation(transition->anim, &transition_animation_implementation);
+  return transition;
+}
+
+void transition_set_duration(Transition* transition, uint32_t duration_ms) {
+  transition->duration = duration_ms;
+}
+
+bool transition_add_client(Transition* transition, const TransitionClientImplementation* implementation, void* client) {
+  if (transition->num_clients == TRANSITION_MAX_CLIENTS) return false;
+  transition->clients[transition->num_clients++] = (TransitionClient){implementation, client, false};
+  return true;
+}
+
+bool transition_add_split_flap_layer(Transition* transition, SplitFlapLayer* split_layer) {
+  return transition_add_client(transition, &transition_split_flap_implementation, split_layer);
+}
+
+bool transition_add_dots_layer(Transition* transition, DotsLayer* dots_layer) {
+  return transition_add_client(transition, &transition_dots_implementation, dots_layer);
+}
+
+bool transition_is_running(Transition* transition) {
+  return animation_is_scheduled(transition->anim);
+}
+
+void transition_set_page(Transition* transition, uint32_t page_idx) {
+  if (transition_is_running(transition)) {
+    // The stopped handler settles everyone on the page they were heading for.
+    animation_unschedule(transition->anim);
+  }
+  bool any_active = false;
+  for (int i = 0; i < transition->num_clients; ++i) {
+    TransitionClient* client = &transition->clients[i];
+    client->active = client->implementation->begin(client->client, page_idx);
+    any_active |= client->active;
+  }
+  if (any_active) {
+    animation_set_duration(transition->anim, transition->duration);
+    animation_schedule(transition->anim);
+  }
+}
+
+void transition_destroy(Transition* transition) {
+  if (transition_is_running(transition)) {
+    animation_unschedule(transition->anim);
+  }
+  animation_destroy(transition->anim);
+  free(transition);
+}
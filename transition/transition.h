@@ -0,0 +1,34 @@
+#pragma once
+#include <pebble.h>
+#include "split_flap.h"
+#include "dots.h"
+
+typedef struct Transition Transition;
+
+// What a transition needs from each control it drives - the same begin/progress/end shape as split_flap_layer_begin_flip and friends.
+typedef struct TransitionClientImplementation {
+  // Start heading for page_idx. Return false if there's nothing to animate.
+  bool (*begin)(void* client, uint32_t page_idx);
+  // Move to time_normal (0 to ANIMATION_NORMALIZED_MAX) of the way there. Don't mark anything dirty - the transition does that.
+  void (*set_progress)(void* client, uint32_t time_normal);
+  void (*end)(void* client);
+} TransitionClientImplementation;
+
+#define TRANSITION_MAX_CLIENTS 4
+
+// Create a transition (NULL if there isn't the memory). layer is marked dirty once per frame on everyone's behalf - the window's root layer covers everything.
+Transition* transition_create(Layer* layer);
+// How long page changes take (200ms by default).
+void transition_set_duration(Transition* transition, uint32_t duration_ms);
+// Drive a SplitFlapLayer's flips. Returns false if there's no room (TRANSITION_MAX_CLIENTS), as do the other two.
+bool transition_add_split_flap_layer(Transition* transition, SplitFlapLayer* split_layer);
+// Drive a DotsLayer's indicator (the number of dots is still up to you, with dots_layer_update).
+bool transition_add_dots_layer(Transition* transition, DotsLayer* dots_layer);
+// Drive something else. Returns false if there's no room (TRANSITION_MAX_CLIENTS).
+bool transition_add_client(Transition* transition, const TransitionClientImplementation* implementation, void* client);
+// Move everyone to page_idx together. A transition still running gets finished off first.
+void transition_set_page(Transition* transition, uint32_t page_idx);
+// Is a page change in progress?
+bool transition_is_running(Transition* transition);
+// Destroys a transition (but not its clients).
+void transition_destroy(Transition* transition);